@@ -0,0 +1,46 @@
+/// Format of the page reference traces recorded by Nachos (see the `-tr`
+/// option) and replayed by `pagesim`.
+///
+/// A trace is a header followed by records, in the byte order of the host
+/// that recorded it.  Each record stands for `count` consecutive references
+/// to the same page, made by the same process and of the same kind; a
+/// reference that faulted is always a record of its own, followed by the
+/// record of the same reference when it is retried.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_BIN_PAGETRACE__H
+#define NACHOS_BIN_PAGETRACE__H
+
+
+#include <stdint.h>
+
+
+#define PAGE_TRACE_MAGIC  0x50475452  // "PGTR"
+
+#define PAGE_TRACE_WRITE  0x1  // The reference was a write.
+#define PAGE_TRACE_FAULT  0x2  // The reference found the page out of
+                               // memory, and Nachos loaded it: it is
+                               // retried later.  TLB misses on resident
+                               // pages are not faults.  The write bit of
+                               // these records is always clear.
+
+typedef struct pageTraceHeader {
+    uint32_t magic;         // Should be `PAGE_TRACE_MAGIC`.
+    uint32_t pageSize;      // Size of a page, in bytes.
+    uint32_t numPhysPages;  // Number of physical pages of the machine.
+    uint32_t reserved;
+} pageTraceHeader;
+
+typedef struct pageTraceRecord {
+    uint32_t tick;     // Low 32 bits of the time of the first reference.
+    uint32_t vpn;      // Virtual page referenced.
+    uint16_t spaceId;  // Process that made the references.
+    uint8_t  flags;    // `PAGE_TRACE_*` bits.
+    uint8_t  count;    // Number of references, at least 1.
+} pageTraceRecord;
+
+
+#endif
@@ -0,0 +1,339 @@
+/// Program that replays page reference traces recorded by Nachos (see
+/// `page_trace.h`) against several page replacement policies and memory
+/// sizes, and prints the resulting fault rates.
+///
+/// Frames are shared by every process, as in Nachos, and a page is
+/// identified by its process and virtual page number.  References that
+/// faulted in Nachos are skipped: they show up again when retried.
+///
+/// Policies:
+/// * `fifo`   -- evict the page loaded first.
+/// * `lru`    -- evict the page referenced least recently.
+/// * `clock`  -- second chance, with a reference bit per frame.
+/// * `random` -- evict a page at random (with a fixed seed).
+/// * `opt`    -- Belady's optimal policy: evict the page whose next
+///               reference is the farthest away.  Needs the whole trace, so
+///               it is only a bound for the others.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "page_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+enum { FIFO, LRU, CLOCK, RANDOM, OPT, NUM_POLICIES };
+
+static const char *policyNames[NUM_POLICIES] = {
+    "fifo", "lru", "clock", "random", "opt"
+};
+
+/// The references of the trace, with every page replaced by a dense
+/// number.
+typedef struct trace {
+    unsigned *pages;       // Page of each reference run.
+    unsigned *counts;      // Number of references in each run.
+    unsigned *nextUse;     // Index of the next run of the same page, or
+                           // `numRuns` if there is none.
+    unsigned numRuns;
+    unsigned long numReferences;
+    unsigned numPages;     // Number of distinct pages.
+    unsigned long numFaults;  // Page faults recorded by Nachos.
+    pageTraceHeader header;
+} trace;
+
+static void *
+Allocate(size_t size)
+{
+    void *p = malloc(size);
+    if (p == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+/// Return the dense number of the page `key`, giving it the next one if it
+/// is new.  `keys` and `ids` form an open addressing hash table of
+/// `tableSize` entries, a power of two.
+static unsigned
+PageNumber(uint64_t key, uint64_t *keys, unsigned *ids, unsigned tableSize,
+           unsigned *numPages)
+{
+    unsigned h = (unsigned) ((key * 0x9E3779B97F4A7C15ULL) >> 40)
+                 & (tableSize - 1);
+    while (ids[h] != 0) {
+        if (keys[h] == key) {
+            return ids[h] - 1;
+        }
+        h = (h + 1) & (tableSize - 1);
+    }
+    keys[h] = key;
+    ids[h] = ++*numPages;
+    return *numPages - 1;
+}
+
+static int
+ReadTrace(const char *path, trace *t)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return 0;
+    }
+    if (fread(&t->header, sizeof t->header, 1, f) != 1
+          || t->header.magic != PAGE_TRACE_MAGIC) {
+        fprintf(stderr, "%s: not a page trace\n", path);
+        fclose(f);
+        return 0;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f) - (long) sizeof t->header;
+    fseek(f, sizeof t->header, SEEK_SET);
+    unsigned numRecords = size / sizeof (pageTraceRecord);
+    pageTraceRecord *records = Allocate(numRecords * sizeof *records + 1);
+    if (fread(records, sizeof *records, numRecords, f) != numRecords) {
+        fprintf(stderr, "%s: truncated trace\n", path);
+        fclose(f);
+        return 0;
+    }
+    fclose(f);
+
+    unsigned tableSize = 1;
+    while (tableSize < 2 * numRecords + 2) {
+        tableSize *= 2;
+    }
+    uint64_t *keys = Allocate(tableSize * sizeof *keys);
+    unsigned *ids  = calloc(tableSize, sizeof *ids);
+    if (ids == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+
+    t->pages  = Allocate(numRecords * sizeof *t->pages + 1);
+    t->counts = Allocate(numRecords * sizeof *t->counts + 1);
+    t->numRuns = t->numPages = 0;
+    t->numReferences = t->numFaults = 0;
+    for (unsigned i = 0; i < numRecords; i++) {
+        if (records[i].flags & PAGE_TRACE_FAULT) {
+            t->numFaults++;
+            continue;
+        }
+        uint64_t key = (uint64_t) records[i].spaceId << 32 | records[i].vpn;
+        unsigned page = PageNumber(key, keys, ids, tableSize, &t->numPages);
+        if (t->numRuns > 0 && t->pages[t->numRuns - 1] == page) {
+            t->counts[t->numRuns - 1] += records[i].count;
+        } else {
+            t->pages[t->numRuns]  = page;
+            t->counts[t->numRuns] = records[i].count;
+            t->numRuns++;
+        }
+        t->numReferences += records[i].count;
+    }
+    free(keys);
+    free(ids);
+    free(records);
+
+    // Link every run to the next one of the same page, for `opt`.
+    unsigned *last = Allocate(t->numPages * sizeof *last + 1);
+    for (unsigned p = 0; p < t->numPages; p++) {
+        last[p] = t->numRuns;
+    }
+    t->nextUse = Allocate(t->numRuns * sizeof *t->nextUse + 1);
+    for (unsigned i = t->numRuns; i-- > 0; ) {
+        t->nextUse[i] = last[t->pages[i]];
+        last[t->pages[i]] = i;
+    }
+    free(last);
+    return 1;
+}
+
+/// Replay the trace with `numFrames` frames, and return the number of
+/// faults.
+static unsigned long
+Simulate(const trace *t, int policy, unsigned numFrames)
+{
+    unsigned *frameOf = Allocate(t->numPages * sizeof *frameOf + 1);
+    for (unsigned p = 0; p < t->numPages; p++) {
+        frameOf[p] = numFrames;  // not resident
+    }
+    unsigned *pageIn  = Allocate(numFrames * sizeof *pageIn);
+    unsigned *stamp   = Allocate(numFrames * sizeof *stamp);
+    unsigned char *referenced = calloc(numFrames, 1);
+
+    unsigned used = 0, hand = 0;
+    unsigned long faults = 0;
+    srand(1);
+
+    for (unsigned i = 0; i < t->numRuns; i++) {
+        unsigned page = t->pages[i];
+        unsigned frame = frameOf[page];
+
+        if (frame == numFrames) {
+            faults++;
+            if (used < numFrames) {
+                frame = used++;
+            } else {
+                switch (policy) {
+                    case FIFO:
+                        frame = hand;
+                        hand = (hand + 1) % numFrames;
+                        break;
+                    case LRU:
+                        frame = 0;
+                        for (unsigned f = 1; f < numFrames; f++) {
+                            if (stamp[f] < stamp[frame]) {
+                                frame = f;
+                            }
+                        }
+                        break;
+                    case CLOCK:
+                        while (referenced[hand]) {
+                            referenced[hand] = 0;
+                            hand = (hand + 1) % numFrames;
+                        }
+                        frame = hand;
+                        hand = (hand + 1) % numFrames;
+                        break;
+                    case RANDOM:
+                        frame = rand() % numFrames;
+                        break;
+                    case OPT:
+                        frame = 0;
+                        for (unsigned f = 1; f < numFrames; f++) {
+                            if (stamp[f] > stamp[frame]) {
+                                frame = f;
+                            }
+                        }
+                        break;
+                }
+                frameOf[pageIn[frame]] = numFrames;
+            }
+            pageIn[frame] = page;
+            frameOf[page] = frame;
+        }
+
+        // `stamp` is the last use for `lru`, and the next use for `opt`.
+        stamp[frame] = policy == OPT ? t->nextUse[i] : i;
+        referenced[frame] = 1;
+    }
+
+    free(frameOf);
+    free(pageIn);
+    free(stamp);
+    free(referenced);
+    return faults;
+}
+
+static void
+Usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [-p <policy>[,<policy>...]] [-f <first>[-<last>]]"
+            " [-c] <trace file>\n"
+            "Policies: fifo, lru, clock, random, opt (all by default).\n"
+            "Frames: from 1 to twice the frames of the traced machine by"
+            " default.\n"
+            "-c prints fault counts instead of fault rates.\n",
+            program);
+    exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int selected[NUM_POLICIES];
+    for (int p = 0; p < NUM_POLICIES; p++) {
+        selected[p] = 1;
+    }
+    unsigned firstFrames = 1, lastFrames = 0;
+    int printCounts = 0;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            for (int p = 0; p < NUM_POLICIES; p++) {
+                selected[p] = 0;
+            }
+            char *list = argv[++i];
+            for (char *name = strtok(list, ","); name != NULL;
+                   name = strtok(NULL, ",")) {
+                int p;
+                for (p = 0; p < NUM_POLICIES; p++) {
+                    if (strcmp(name, policyNames[p]) == 0) {
+                        break;
+                    }
+                }
+                if (p == NUM_POLICIES) {
+                    fprintf(stderr, "Unknown policy `%s`\n", name);
+                    Usage(argv[0]);
+                }
+                selected[p] = 1;
+            }
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            char *end;
+            firstFrames = strtoul(argv[++i], &end, 10);
+            lastFrames = *end == '-' ? strtoul(end + 1, NULL, 10)
+                                     : firstFrames;
+            if (firstFrames == 0 || lastFrames < firstFrames) {
+                Usage(argv[0]);
+            }
+        } else if (strcmp(argv[i], "-c") == 0) {
+            printCounts = 1;
+        } else if (argv[i][0] != '-' && path == NULL) {
+            path = argv[i];
+        } else {
+            Usage(argv[0]);
+        }
+    }
+    if (path == NULL) {
+        Usage(argv[0]);
+    }
+
+    trace t;
+    if (!ReadTrace(path, &t)) {
+        return 1;
+    }
+    if (lastFrames == 0) {
+        lastFrames = 2 * t.header.numPhysPages;
+    }
+
+    printf("%s: %lu references, %u distinct pages of %u bytes,"
+           " %lu page faults in Nachos with %u frames\n",
+           path, t.numReferences, t.numPages, t.header.pageSize,
+           t.numFaults, t.header.numPhysPages);
+    if (t.numReferences == 0) {
+        return 0;
+    }
+
+    printf("%8s", "frames");
+    for (int p = 0; p < NUM_POLICIES; p++) {
+        if (selected[p]) {
+            printf(" %10s", policyNames[p]);
+        }
+    }
+    printf("\n");
+
+    for (unsigned frames = firstFrames; frames <= lastFrames; frames++) {
+        printf("%8u", frames);
+        for (int p = 0; p < NUM_POLICIES; p++) {
+            if (!selected[p]) {
+                continue;
+            }
+            unsigned long faults = Simulate(&t, p, frames);
+            if (printCounts) {
+                printf(" %10lu", faults);
+            } else {
+                printf(" %9.3f%%", 100.0 * faults / t.numReferences);
+            }
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -282,6 +282,7 @@ FileSystem::Create(const char *name, unsigned dummyParam, bool isBin) // Dummy p
             openFilesTable[sector]->writeLock = nullptr;
             openFilesTable[sector]->closeLock = nullptr;
             openFilesTable[sector]->count = 0;
+            openFilesTable[sector]->version++;  // not the file that was there
 
             DEBUG('f',"File created successfully!\n");
             delete firstHeader;
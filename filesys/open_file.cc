@@ -100,16 +100,54 @@ OpenFile::Close()
 void
 OpenFile::Seek(unsigned position)
 {
+    if(isBin) {
+        currentOffset = position;
+        return;
+    }
+
+    // Walk the chain of headers up to the one that holds `position`.  A
+    // position at the end of a full header belongs to the next one, if
+    // there is one.
+    currentSector = sector;
+    hdr->FetchFrom(currentSector);
+    unsigned next = hdr->GetRaw()->nextFileHeader;
+    while (position >= hdr->GetRaw()->numBytes && next != 0) {
+        position -= hdr->GetRaw()->numBytes;
+        currentSector = next;
+        hdr->FetchFrom(currentSector);
+        next = hdr->GetRaw()->nextFileHeader;
+    }
     seekPosition = position;
 }
 
+unsigned
+OpenFile::Tell() const
+{
+    if(isBin) {
+        return currentOffset;
+    }
+
+    // Add up the bytes of the headers that come before the current one.
+    FileHeader *h = new FileHeader;
+    unsigned position = 0;
+    for (unsigned s = sector; s != (unsigned) currentSector;
+           s = h->GetRaw()->nextFileHeader) {
+        ASSERT(s != 0);
+        h->FetchFrom(s);
+        position += h->GetRaw()->numBytes;
+    }
+    delete h;
+    return position + seekPosition;
+}
+
 /// OpenFile::Read/Write
 ///
 /// Read/write a portion of a file, starting from `seekPosition`.  Return the
 /// number of bytes actually written or read, and as a side effect, increment
 /// the current position within the file.
 ///
-/// Implemented using the more primitive `ReadAt`/`WriteAt`.
+/// Implemented using the more primitive `ReadInHeader`/`WriteInHeader`,
+/// a header at a time.
 ///
 /// * `into` is the buffer to contain the data to be read from disk.
 /// * `from` is the buffer containing the data to be written to disk.
@@ -129,6 +167,7 @@ OpenFile::Read(char *into, unsigned numBytes, bool isDirectory)
 
     if(isDirectory) {
         hdr->FetchFrom(sector);
+        currentSector = sector;
         seekPosition = 0;
     }
 
@@ -136,7 +175,7 @@ OpenFile::Read(char *into, unsigned numBytes, bool isDirectory)
 
     if (seekPosition + numBytes > hdr->GetRaw()->numBytes) {
         DEBUG('w', "seekPostion is: %u, numBytes is: %u, maximuxbytes is:%u\n",seekPosition,numBytes,hdr->GetRaw()->numBytes);
-        result = ReadAt(into, numBytes, seekPosition);
+        result = ReadInHeader(hdr, into, numBytes, seekPosition);
         seekPosition += result;
         numBytes -= result;
         char* temp = into + result;
@@ -146,7 +185,8 @@ OpenFile::Read(char *into, unsigned numBytes, bool isDirectory)
         while(nextSector && numBytes > 0) {
             seekPosition = 0;
             hdr->FetchFrom(nextSector);
-            unsigned result_tmp = ReadAt(temp, numBytes, seekPosition);
+            currentSector = nextSector;
+            unsigned result_tmp = ReadInHeader(hdr, temp, numBytes, seekPosition);
             temp+= result_tmp;
             numBytes -= result_tmp;
             result += result_tmp;
@@ -158,7 +198,7 @@ OpenFile::Read(char *into, unsigned numBytes, bool isDirectory)
         }
     } else {
         DEBUG('w', "going to read with read at!\n");
-        result = ReadAt(into, numBytes, seekPosition);
+        result = ReadInHeader(hdr, into, numBytes, seekPosition);
         DEBUG('w', "bytes read: %u\n", result);
 
         seekPosition += result;
@@ -234,7 +274,7 @@ OpenFile::Write(const char *from, unsigned numBytes, bool isDirectory)
         }
 
         DEBUG('w', "going to write in seek position %d\n", seekPosition);
-        result_tmp = WriteAt(from, bytesToWrite, seekPosition);
+        result_tmp = WriteInHeader(hdr, from, bytesToWrite, seekPosition);
 
         ////////////////// Updating data //////////////////////
         result += result_tmp;
@@ -283,7 +323,7 @@ OpenFile::Write(const char *from, unsigned numBytes, bool isDirectory)
         currentSector = iterFh;
 
         seekPosition = 0;
-        result_tmp = WriteAt(from, bytesToWrite, seekPosition);
+        result_tmp = WriteInHeader(hdr, from, bytesToWrite, seekPosition);
         result += result_tmp;
         from += result_tmp; //Move the array of char pointers reslt_tmp times
 
@@ -358,7 +398,7 @@ OpenFile::Write(const char *from, unsigned numBytes, bool isDirectory)
         ////////////////// Updating data //////////////////////
         seekPosition = 0;
 
-        result_tmp = WriteAt(from, bytesToAllocate, seekPosition);
+        result_tmp = WriteInHeader(hdr, from, bytesToAllocate, seekPosition);
         DEBUG('w', "The bytes writed in the current FH are: %u\n", result_tmp);
         result += result_tmp;
         from += result_tmp; //Move the array of char pointers result_tmp times
@@ -401,7 +441,7 @@ OpenFile::Write(const char *from, unsigned numBytes, bool isDirectory)
                 ////////////////// Updating data //////////////////////
                 seekPosition = 0;
                 hdr = newFileHeader;
-                result_tmp = WriteAt(from, bytesToAllocate, seekPosition);
+                result_tmp = WriteInHeader(hdr, from, bytesToAllocate, seekPosition);
                 result += result_tmp;
                 from += result_tmp; //Move the array of char pointers reslt_tmp times
                 DEBUG('w', "the size of from is: %u\n", sizeof(from));
@@ -439,24 +479,31 @@ OpenFile::Write(const char *from, unsigned numBytes, bool isDirectory)
     return result;
 }
 
+/// Return how many sectors of the part of the file described by `h`,
+/// starting at sector `first` and up to `last`, follow each other on disk.
+unsigned
+OpenFile::ContiguousSectors(FileHeader *h, unsigned first, unsigned last) const
+{
+    unsigned start = h->ByteToSector(first * SECTOR_SIZE);
+    unsigned run = 1;
+    while (first + run <= last
+             && h->ByteToSector((first + run) * SECTOR_SIZE) == start + run) {
+        run++;
+    }
+    return run;
+}
+
 /// OpenFile::ReadAt/WriteAt
 ///
 /// Read/write a portion of a file, starting at `position`.  Return the
 /// number of bytes actually written or read, but has no side effects (except
-/// that `Write` modifies the file, of course).
-///
-/// There is no guarantee the request starts or ends on an even disk sector
-/// boundary; however the disk only knows how to read/write a whole disk
-/// sector at a time.  Thus:
+/// that `Write` modifies the file, of course).  In particular, the implicit
+/// position and the header it is in are left alone.  A write that starts
+/// at or before the end of the file can make it longer, but a write past
+/// the end does nothing, as files cannot have holes.
 ///
-/// For ReadAt:
-///     We read in all of the full or partial sectors that are part of the
-///     request, but we only copy the part we are interested in.
-/// For WriteAt:
-///     We must first read in any sectors that will be partially written, so
-///     that we do not overwrite the unmodified portion.  We then copy in the
-///     data that will be modified, and write back all the full or partial
-///     sectors that are part of the request.
+/// Big files take a chain of headers, so the chain is walked from the first
+/// header, and each one gets the part of the request that it covers.
 ///
 /// * `into` is the buffer to contain the data to be read from disk.
 /// * `from` is the buffer containing the data to be written to disk.
@@ -475,7 +522,109 @@ OpenFile::ReadAt(char *into, unsigned numBytes, unsigned position)
         return SystemDep::ReadPartial(file, into, numBytes);
     }
 
-    unsigned fileLength = hdr->FileLength(); // raw.numBytes (size): 416
+    // Sector 0 holds a header too, so the walk stops on a zero
+    // `nextFileHeader` rather than on a zero sector.
+    FileHeader *h = new FileHeader;
+    h->FetchFrom(sector);
+    int result = 0;
+    for (;;) {
+        unsigned length = h->FileLength();
+        if (position < length) {
+            unsigned count = numBytes < length - position ? numBytes
+                                                          : length - position;
+            int numRead = ReadInHeader(h, into, count, position);
+            result   += numRead;
+            into     += numRead;
+            numBytes -= numRead;
+            position  = 0;
+        } else {
+            position -= length;
+        }
+        unsigned next = h->GetRaw()->nextFileHeader;
+        if (numBytes == 0 || next == 0) {
+            break;
+        }
+        h->FetchFrom(next);
+    }
+    delete h;
+    return result;
+}
+
+int
+OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
+{
+    ASSERT(from != nullptr);
+    ASSERT(numBytes > 0);
+
+    if(isBin) {
+        SystemDep::Lseek(file, position, 0);
+        SystemDep::WriteFile(file, from, numBytes);
+        return numBytes;
+    }
+
+    // Sector 0 holds a header too, so the walk stops on a zero
+    // `nextFileHeader` rather than on a zero sector.
+    FileHeader *h = new FileHeader;
+    h->FetchFrom(sector);
+    int result = 0;
+    for (;;) {
+        unsigned length = h->FileLength();
+        if (position < length) {
+            unsigned count = numBytes < length - position ? numBytes
+                                                          : length - position;
+            int numWritten = WriteInHeader(h, from, count, position);
+            result   += numWritten;
+            from     += numWritten;
+            numBytes -= numWritten;
+            position  = 0;
+        } else {
+            position -= length;
+        }
+        unsigned next = h->GetRaw()->nextFileHeader;
+        if (numBytes == 0 || next == 0) {
+            break;
+        }
+        h->FetchFrom(next);
+    }
+    delete h;
+
+    // The rest goes right past the end of the file.  It is written through
+    // an open file of our own, that grows the file like `Write` does,
+    // without moving the position of this one.
+    if (numBytes > 0 && position == 0) {
+        OpenFile *tail = new OpenFile(sector);
+        tail->Seek(tail->Length());
+        result += tail->Write(from, numBytes);
+        delete tail;
+
+        // The header of the current position may be the one that grew.
+        hdr->FetchFrom(currentSector);
+    }
+    return result;
+}
+
+/// OpenFile::ReadInHeader/WriteInHeader
+///
+/// Transfer a portion of the part of the file described by the header `h`.
+///
+/// There is no guarantee the request starts or ends on an even disk sector
+/// boundary; however the disk only knows how to read/write a whole disk
+/// sector at a time.  Thus:
+///
+/// For ReadInHeader:
+///     We read in all of the full or partial sectors that are part of the
+///     request, but we only copy the part we are interested in.
+/// For WriteInHeader:
+///     We must first read in any sectors that will be partially written, so
+///     that we do not overwrite the unmodified portion.  We then copy in the
+///     data that will be modified, and write back all the full or partial
+///     sectors that are part of the request.
+
+int
+OpenFile::ReadInHeader(FileHeader *h, char *into,
+                       unsigned numBytes, unsigned position)
+{
+    unsigned fileLength = h->FileLength();
     unsigned firstSector, lastSector, numSectors;
     char *buf;
 
@@ -493,12 +642,15 @@ OpenFile::ReadAt(char *into, unsigned numBytes, unsigned position)
     lastSector = DivRoundDown(position + numBytes - 1, SECTOR_SIZE);
     numSectors = 1 + lastSector - firstSector;
 
-    // Read in all the full and partial sectors that we need.
+    // Read in all the full and partial sectors that we need, a run of
+    // consecutive sectors on disk at a time.
     buf = new char [numSectors * SECTOR_SIZE];
-    for (unsigned i = firstSector; i <= lastSector; i++) {
-        unsigned sectorToRead = hdr->ByteToSector(i * SECTOR_SIZE);
-        synchDisk->ReadSector(sectorToRead,
-                              &buf[(i - firstSector) * SECTOR_SIZE]);
+    for (unsigned i = firstSector; i <= lastSector; ) {
+        unsigned sectorToRead = h->ByteToSector(i * SECTOR_SIZE);
+        unsigned run = ContiguousSectors(h, i, lastSector);
+        synchDisk->ReadSectors(sectorToRead, run,
+                               &buf[(i - firstSector) * SECTOR_SIZE]);
+        i += run;
     }
 
     // Copy the part we want.
@@ -508,18 +660,10 @@ OpenFile::ReadAt(char *into, unsigned numBytes, unsigned position)
 }
 
 int
-OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
+OpenFile::WriteInHeader(FileHeader *h, const char *from,
+                        unsigned numBytes, unsigned position)
 {
-    ASSERT(from != nullptr);
-    ASSERT(numBytes > 0);
-
-    if(isBin) {
-        SystemDep::Lseek(file, position, 0);
-        SystemDep::WriteFile(file, from, numBytes);
-        return numBytes;
-    }
-
-    unsigned fileLength = hdr->FileLength();
+    unsigned fileLength = h->FileLength();
     unsigned firstSector, lastSector, numSectors;
     bool firstAligned, lastAligned;
     char *buf;
@@ -532,6 +676,7 @@ OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
     }
     DEBUG('f', "Writing %u bytes at %u, from file of length %u.\n",
           numBytes, position, fileLength);
+    openFilesTable[sector]->version++;
 
     firstSector = DivRoundDown(position, SECTOR_SIZE);
     lastSector  = DivRoundDown(position + numBytes - 1, SECTOR_SIZE);
@@ -544,26 +689,28 @@ OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
 
     // Read in first and last sector, if they are to be partially modified.
     if (!firstAligned) {
-        ReadAt(buf, SECTOR_SIZE, firstSector * SECTOR_SIZE);
+        ReadInHeader(h, buf, SECTOR_SIZE, firstSector * SECTOR_SIZE);
     }
     if (!lastAligned && (firstSector != lastSector || firstAligned)) {
-        ReadAt(&buf[(lastSector - firstSector) * SECTOR_SIZE],
-               SECTOR_SIZE, lastSector * SECTOR_SIZE);
+        ReadInHeader(h, &buf[(lastSector - firstSector) * SECTOR_SIZE],
+                     SECTOR_SIZE, lastSector * SECTOR_SIZE);
     }
 
     // Copy in the bytes we want to change.
     memcpy(&buf[position - firstSector * SECTOR_SIZE], from, numBytes);
 
     // Write modified sectors back.
-    for (unsigned i = firstSector; i <= lastSector; i++) {
-        synchDisk->WriteSector(hdr->ByteToSector(i * SECTOR_SIZE),
-                               &buf[(i - firstSector) * SECTOR_SIZE]);
+    for (unsigned i = firstSector; i <= lastSector; ) {
+        unsigned run = ContiguousSectors(h, i, lastSector);
+        synchDisk->WriteSectors(h->ByteToSector(i * SECTOR_SIZE), run,
+                                &buf[(i - firstSector) * SECTOR_SIZE]);
+        i += run;
     }
     delete [] buf;
     return numBytes;
 }
 
-/// Return the number of bytes in the file.
+/// Return the number of bytes in the file, over all its headers.
 unsigned
 OpenFile::Length() const
 {
@@ -571,7 +718,15 @@ OpenFile::Length() const
         SystemDep::Lseek(file, 0, 2);
         return SystemDep::Tell(file);
     }
-    return hdr->FileLength();
+
+    FileHeader *h = new FileHeader;
+    unsigned length = 0;
+    for (unsigned s = sector; s != 0; s = h->GetRaw()->nextFileHeader) {
+        h->FetchFrom(s);
+        length += h->FileLength();
+    }
+    delete h;
+    return length;
 }
 
 int
@@ -579,3 +734,20 @@ OpenFile::GetSector()
 {
     return sector;
 }
+
+/// Nachos files are told apart by the sector of their first header, and
+/// their version is bumped on every write.  Files of the host are stamped
+/// as in the stub.
+FileStamp
+OpenFile::GetStamp() const
+{
+    FileStamp stamp;
+    if(isBin) {
+        SystemDep::Stat(file, &stamp.device, &stamp.inode, &stamp.version);
+        return stamp;
+    }
+    stamp.device  = 0;
+    stamp.inode   = sector;
+    stamp.version = openFilesTable[sector]->version;
+    return stamp;
+}
@@ -23,6 +23,21 @@
 #include "lib/utility.hh"
 
 
+/// Which file an open file is, and which version of its contents: two
+/// stamps are equal only if they are of the same file, and it was not
+/// written to in between.
+struct FileStamp {
+    unsigned long long device;
+    unsigned long long inode;
+    unsigned long long version;
+
+    bool operator==(const FileStamp &other) const
+    {
+        return device == other.device && inode == other.inode
+                 && version == other.version;
+    }
+};
+
 #ifdef FILESYS_STUB  // Temporarily implement calls to Nachos file system as
                      // calls to UNIX!  See definitions listed under `#else`.
 class OpenFile {
@@ -73,12 +88,31 @@ public:
         return numWritten;
     }
 
+    void Seek(unsigned position)
+    {
+        currentOffset = position;
+    }
+
+    unsigned Tell() const
+    {
+        return currentOffset;
+    }
+
     unsigned Length() const
     {
         SystemDep::Lseek(file, 0, 2);
         return SystemDep::Tell(file);
     }
 
+    /// The version is the time of the last modification, so that changes
+    /// made from outside Nachos count as well.
+    FileStamp GetStamp() const
+    {
+        FileStamp stamp;
+        SystemDep::Stat(file, &stamp.device, &stamp.inode, &stamp.version);
+        return stamp;
+    }
+
 private:
     int file;
     unsigned currentOffset;
@@ -99,6 +133,9 @@ public:
     /// Set the position from which to start reading/writing -- UNIX `lseek`.
     void Seek(unsigned position);
 
+    /// Return the position from which the next read/write starts.
+    unsigned Tell() const;
+
     /// Read/write bytes from the file, starting at the implicit position.
     /// Return the # actually read/written, and increment position in file.
 
@@ -106,6 +143,8 @@ public:
     int Write(const char *from, unsigned numBytes, bool isDirectory = false);
 
     /// Read/write bytes from the file, bypassing the implicit position.
+    /// `position` counts from the start of the file, over all its headers.
+    /// Writes can make the file longer, but cannot start past its end.
 
     int ReadAt(char *into, unsigned numBytes, unsigned position);
     int WriteAt(const char *from, unsigned numBytes, unsigned position);
@@ -116,10 +155,29 @@ public:
 
     int GetSector();
 
+    /// Tell which file this is, and which version of it; see `FileStamp`.
+    FileStamp GetStamp() const;
+
     // Closes a file (just calls the deconstructor of the class)
     void Close();
 
   private:
+    /// Read/write bytes of the part of the file described by the header
+    /// `h`, with `position` relative to the bytes it covers.
+    int ReadInHeader(FileHeader *h, char *into,
+                     unsigned numBytes, unsigned position);
+    int WriteInHeader(FileHeader *h, const char *from,
+                      unsigned numBytes, unsigned position);
+
+    /// Number of sectors of the part of the file described by `h`, from
+    /// `first` to `last`, that follow each other on disk, so that they can
+    /// be transferred together.
+    unsigned ContiguousSectors(FileHeader *h,
+                               unsigned first, unsigned last) const;
+
+    /// Big files take a chain of headers, linked by `nextFileHeader`.
+    /// `hdr` is the one at `currentSector`, and `seekPosition` is relative
+    /// to the bytes it covers.
     FileHeader *hdr;  ///< Header for this file.
     int currentSector;
     unsigned seekPosition;  ///< Current position within the file.
@@ -78,6 +78,45 @@ SynchDisk::WriteSector(int sectorNumber, const char *data)
     lock->Release();
 }
 
+/// Read `count` consecutive sectors into a buffer, holding the disk for the
+/// whole transfer.
+///
+/// * `firstSector` is the first disk sector to read.
+/// * `count` is the number of sectors.
+/// * `data` is the buffer to hold their contents, `count * SECTOR_SIZE`
+///   bytes.
+void
+SynchDisk::ReadSectors(int firstSector, unsigned count, char *data)
+{
+    ASSERT(data != nullptr);
+
+    lock->Acquire();
+    for (unsigned i = 0; i < count; i++) {
+        disk->ReadRequest(firstSector + i, &data[i * SECTOR_SIZE]);
+        semaphore->P();
+    }
+    lock->Release();
+}
+
+/// Write a buffer into `count` consecutive sectors, holding the disk for
+/// the whole transfer.
+///
+/// * `firstSector` is the first disk sector to be written.
+/// * `count` is the number of sectors.
+/// * `data` are their new contents, `count * SECTOR_SIZE` bytes.
+void
+SynchDisk::WriteSectors(int firstSector, unsigned count, const char *data)
+{
+    ASSERT(data != nullptr);
+
+    lock->Acquire();
+    for (unsigned i = 0; i < count; i++) {
+        disk->WriteRequest(firstSector + i, &data[i * SECTOR_SIZE]);
+        semaphore->P();
+    }
+    lock->Release();
+}
+
 /// Disk interrupt handler.  Wake up any thread waiting for the disk
 /// request to finish.
 void
@@ -39,6 +39,14 @@ public:
     void ReadSector(int sectorNumber, char *data);
     void WriteSector(int sectorNumber, const char *data);
 
+    /// Read/write `count` consecutive sectors, starting at `firstSector`,
+    /// without letting other requests in between, so that the disk can
+    /// stream them from its track buffer.  Used for pages larger than a
+    /// sector.
+
+    void ReadSectors(int firstSector, unsigned count, char *data);
+    void WriteSectors(int firstSector, unsigned count, const char *data);
+
     /// Called by the disk device interrupt handler, to signal that the
     /// current disk operation is complete.
     void RequestDone();
@@ -18,6 +18,7 @@
 #include "threads/system.hh"
 
 #include <stdio.h>
+#include <string.h>
 
 
 /// Dummy functions because C++ is weird about pointers to member functions.
@@ -72,7 +73,8 @@ Console::Console(const char *readFile, const char *writeFile,
     readHandler  = readAvail;
     handlerArg   = callArg;
     putBusy      = false;
-    incoming     = EOF;
+    putCount     = 0;
+    incomingHead = incomingCount = 0;
 
     DEBUG('i', "Scheduling an interrupt for the console read in console::console...\n");
     // Start polling for incoming packets.
@@ -91,42 +93,44 @@ Console::~Console()
     }
 }
 
-/// Periodically called to check if a character is available for
-/// input from the simulated keyboard (eg, has it been typed?).
+/// Periodically called to check if characters are available for input
+/// from the simulated keyboard (eg, have they been typed?).
 ///
-/// Only read it in if there is buffer space for it (if the previous
-/// character has been grabbed out of the buffer by the Nachos kernel).
-/// Invoke the “read” interrupt handler, once the character has been put into
-/// the buffer.
+/// Only read them in if the buffer is empty (if the previous ones have all
+/// been grabbed out of it by the Nachos kernel), and then read everything
+/// that is available, up to the size of the buffer.  Invoke the “read”
+/// interrupt handler, once the characters have been put into the buffer.
 void
 Console::CheckCharAvail()
 {
-    char c;
-
     DEBUG('i', "Scheduling an interrupt for the console read in console::checkcharavail...\n");
     // Schedule the next time to poll for a packet.
     interrupt->Schedule(ConsoleReadPoll, this,
             CONSOLE_TIME, CONSOLE_READ_INT);
 
-    // Do nothing if character is already buffered, or none to be read.
-    if (incoming != EOF || !SystemDep::PollFile(readFileNo)) {
+    // Do nothing if characters are already buffered, or none to be read.
+    if (incomingCount != 0 || !SystemDep::PollFile(readFileNo)) {
         return;
     }
 
-    // Otherwise, read character and tell user about it.
-    SystemDep::Read(readFileNo, &c, sizeof c);
-    incoming = c;
-    stats->numConsoleCharsRead++;
+    // Otherwise, read characters and tell user about them.
+    int n = SystemDep::ReadPartial(readFileNo, incoming, sizeof incoming);
+    ASSERT(n > 0);
+    incomingHead  = 0;
+    incomingCount = n;
+    stats->numConsoleCharsRead += n;
+    stats->numConsoleReads++;
     (*readHandler)(handlerArg);
 }
 
 /// Internal routine called when it is time to invoke the interrupt handler
-/// to tell the Nachos kernel that the output character has completed.
+/// to tell the Nachos kernel that the output characters have completed.
 void
 Console::WriteDone()
 {
     putBusy = false;
-    stats->numConsoleCharsWritten++;
+    stats->numConsoleCharsWritten += putCount;
+    stats->numConsoleWrites++;
     (*writeHandler)(handlerArg);
 }
 
@@ -135,10 +139,24 @@ Console::WriteDone()
 char
 Console::GetChar()
 {
-    char ch = incoming;
+    char ch;
+    return GetBlock(&ch, 1) == 0 ? EOF : ch;
+}
 
-    incoming = EOF;
-    return ch;
+/// Read up to `count` characters from the input buffer into `into`, and
+/// return how many there were.
+unsigned
+Console::GetBlock(char *into, unsigned count)
+{
+    ASSERT(into != nullptr);
+
+    if (count > incomingCount) {
+        count = incomingCount;
+    }
+    memcpy(into, &incoming[incomingHead], count);
+    incomingHead  += count;
+    incomingCount -= count;
+    return count;
 }
 
 /// Write a character to the simulated display, schedule an interrupt to
@@ -146,9 +164,21 @@ Console::GetChar()
 void
 Console::PutChar(char ch)
 {
+    PutBlock(&ch, 1);
+}
+
+/// Write `count` characters to the simulated display with a single host
+/// write, schedule a single interrupt to occur in the future, and return.
+void
+Console::PutBlock(const char *data, unsigned count)
+{
+    ASSERT(data != nullptr);
+    ASSERT(count > 0 && count <= CONSOLE_BLOCK_SIZE);
     ASSERT(!putBusy);
-    SystemDep::WriteFile(writeFileNo, &ch, sizeof (char));
-    putBusy = true;
+
+    SystemDep::WriteFile(writeFileNo, data, count);
+    putBusy  = true;
+    putCount = count;
     interrupt->Schedule(ConsoleWriteDone, this,
                         CONSOLE_TIME, CONSOLE_WRITE_INT);
 }
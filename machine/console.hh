@@ -13,6 +13,11 @@
 /// write, and the device is “duplex” -- a character can be outgoing and
 /// incoming at the same time.
 ///
+/// Characters can also be moved a block at a time: the keyboard keeps
+/// whatever has been typed in a FIFO, filled with a single interrupt, and a
+/// block written to the display takes a single host write and a single
+/// interrupt.
+///
 /// DO NOT CHANGE -- part of the machine emulation
 ///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
@@ -27,6 +32,10 @@
 #include "lib/utility.hh"
 
 
+/// Capacity of the keyboard FIFO, and largest block the display takes at a
+/// time.
+const unsigned CONSOLE_BLOCK_SIZE = 128;
+
 /// The following class defines a hardware console device.
 ///
 /// Input and output to the device is simulated by reading and writing to
@@ -53,11 +62,21 @@ public:
     /// `writeHandler` is called when the I/O completes.
     void PutChar(char ch);
 
+    /// Write the `count` characters in `data` to the console display, and
+    /// return immediately.  `writeHandler` is called once, when all of them
+    /// have been put.  `count` is at most `CONSOLE_BLOCK_SIZE`.
+    void PutBlock(const char *data, unsigned count);
+
     /// Poll the console input.  If a char is available, return it.
     /// Otherwise, return EOF.  `readHandler` is called whenever there is a
     /// char to be gotten.
     char GetChar();
 
+    /// Move up to `count` characters of the console input into `into`, and
+    /// return how many.  `readHandler` is called whenever characters arrive
+    /// into an empty FIFO.
+    unsigned GetBlock(char *into, unsigned count);
+
     // Internal emulation routines -- DO NOT call these.
     // Internal routines to signal I/O completion.
 
@@ -74,8 +93,11 @@ public:
     void *handlerArg;  ///< argument to be passed to the interrupt handlers.
     bool putBusy;  ///< Is a `PutChar` operation in progress?  If so, you
                    ///< cannot do another one!
-    char incoming;  ///< Contains the character to be read, if there is one
-                    ///< available.  Otherwise contains EOF.
+    unsigned putCount;  ///< Characters in the operation in progress.
+    char incoming[CONSOLE_BLOCK_SIZE];  ///< Characters read from the
+                                        ///< keyboard and not yet gotten.
+    unsigned incomingHead;  ///< Next character of `incoming` to be gotten.
+    unsigned incomingCount;  ///< Characters left in `incoming`.
 };
 
 
@@ -36,11 +36,11 @@ const OpInfo OP_TABLE[] = {
     { OP_SWL,   IFMT }, { OP_SW,    IFMT },
     { OP_RES,   IFMT }, { OP_RES,   IFMT },
     { OP_SWR,   IFMT }, { OP_RES,   IFMT },
-    { OP_UNIMP, IFMT }, { OP_UNIMP, IFMT },
+    { OP_LL,    IFMT }, { OP_UNIMP, IFMT },
     { OP_UNIMP, IFMT }, { OP_UNIMP, IFMT },
     { OP_RES,   IFMT }, { OP_RES,   IFMT },
     { OP_RES,   IFMT }, { OP_RES,   IFMT },
-    { OP_UNIMP, IFMT }, { OP_UNIMP, IFMT },
+    { OP_SC,    IFMT }, { OP_UNIMP, IFMT },
     { OP_UNIMP, IFMT }, { OP_UNIMP, IFMT },
     { OP_RES,   IFMT }, { OP_RES,   IFMT },
     { OP_RES,   IFMT }, { OP_RES,   IFMT }
@@ -128,6 +128,8 @@ const struct OpString OP_STRINGS[] = {
     { "XOR r%d,r%d,r%d",   { RD,    RS,    RT    }},
     { "XORI r%d,r%d,%d",   { RT,    RS,    EXTRA }},
     { "SYSCALL",           { NONE,  NONE,  NONE  }},
+    { "LL r%d,%d(r%d)",    { RT,    EXTRA, RS    }},
+    { "SC r%d,%d(r%d)",    { RT,    EXTRA, RS    }},
     { "Unimplemented",     { NONE,  NONE,  NONE  }},
     { "Reserved",          { NONE,  NONE,  NONE  }}
 };
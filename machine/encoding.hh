@@ -22,6 +22,9 @@
 /// `OP_RES`
 ///     Means that this is a reserved opcode (it is not supported by the
 ///     architecture).
+///
+/// `OP_LL` and `OP_SC` come from MIPS II, so that user programs have an
+/// atomic read-modify-write.
 enum {
     OP_ADD      =  1,
     OP_ADDI     =  2,
@@ -84,11 +87,13 @@ enum {
     OP_XOR      = 59,
     OP_XORI     = 60,
     OP_SYSCALL  = 61,
+    OP_LL       = 62,
+    OP_SC       = 63,
 
-    OP_UNIMP    = 62,
-    OP_RES      = 63,
+    OP_UNIMP    = 64,
+    OP_RES      = 65,
 
-    MAX_OPCODE  = 63
+    MAX_OPCODE  = 65
 };
 
 /// Miscellaneous definitions.
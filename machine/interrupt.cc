@@ -227,6 +227,11 @@ Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+#ifdef USER_PROGRAM
+    if (syscallStats != nullptr) {
+        syscallStats->Print();
+    }
+#endif
     Cleanup();  // Never returns.
 }
 
@@ -56,6 +56,7 @@ Machine::Machine(SingleStepper *st)
     }
 
     singleStepper = st;
+    linked = false;
     CheckEndian();
 }
 
@@ -91,6 +92,12 @@ Machine::WriteRegister(unsigned num, int value)
     }
 }
 
+void
+Machine::ClearLink()
+{
+    linked = false;
+}
+
 bool
 Machine::ReadMem(unsigned addr, unsigned size, int *value)
 {
@@ -130,6 +137,7 @@ Machine::RaiseException(ExceptionType et, unsigned badVAddr)
     //ASSERT(interrupt->GetStatus() == USER_MODE);
     registers[BAD_VADDR_REG] = badVAddr;
     DelayedLoad(0, 0);  // Finish anything in progress.
+    linked = false;     // The kernel may run other threads.
 
     // Call the associated handler with interrupts enabled in system mode.
     interrupt->SetStatus(SYSTEM_MODE);
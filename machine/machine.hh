@@ -95,6 +95,10 @@ public:
     /// Print the user CPU and memory state.
     void DumpState();
 
+    /// Make the next `SC` fail, as if another thread had touched the word
+    /// read by the last `LL`.  Called whenever the CPU changes threads.
+    void ClearLink();
+
     /// Routines internal to the machine simulation -- DO NOT call these.
 
     /// Fetch one instruction of a user program.
@@ -131,6 +135,10 @@ private:
 
     MMU mmu; ///< Memory management unit.
 
+    /// Set by `LL`, and cleared by `SC`, by exceptions and by `ClearLink`.
+    /// `SC` only stores while it is set.
+    bool linked;
+
     ExceptionHandler handlers[NUM_EXCEPTION_TYPES];  ///< Exception handlers.
 };
 
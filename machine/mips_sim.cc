@@ -340,6 +340,20 @@ Machine::ExecInstruction(const Instruction *instr)
             nextLoadValue = value;
             break;
 
+        case OP_LL:
+            tmp = registers[instr->rs] + instr->extra;
+            if (tmp & 0x3) {
+                RaiseException(ADDRESS_ERROR_EXCEPTION, tmp);
+                return;
+            }
+            if (!ReadMem(tmp, 4, &value)) {
+                return;
+            }
+            nextLoadReg = instr->rt;
+            nextLoadValue = value;
+            linked = true;
+            break;
+
         case OP_LUI:
             DEBUG('m', "Executing: LUI r%d,%d\n", instr->rt, instr->extra);
             registers[instr->rt] = instr->extra << 16;
@@ -556,6 +570,20 @@ Machine::ExecInstruction(const Instruction *instr)
             }
             break;
 
+        case OP_SC:
+            tmp = registers[instr->rs] + instr->extra;
+            if (tmp & 0x3) {
+                RaiseException(ADDRESS_ERROR_EXCEPTION, tmp);
+                return;
+            }
+            // A fault clears the link, so the retried `SC` fails.
+            if (linked && !WriteMem(tmp, 4, registers[instr->rt])) {
+                return;
+            }
+            registers[instr->rt] = linked;
+            linked = false;
+            break;
+
         case OP_SWL:
             tmp = registers[instr->rs] + instr->extra;
 
@@ -34,6 +34,26 @@
 
 #include <stdio.h>
 
+
+unsigned PAGE_SIZE      = DEFAULT_PAGE_SIZE;
+unsigned NUM_PHYS_PAGES = DEFAULT_NUM_PHYS_PAGES;
+unsigned MEMORY_SIZE    = DEFAULT_NUM_PHYS_PAGES * DEFAULT_PAGE_SIZE;
+unsigned TLB_SIZE       = DEFAULT_TLB_SIZE;
+
+void
+SetMemoryGeometry(unsigned pageSize, unsigned numPhysPages, unsigned tlbSize)
+{
+    ASSERT(pageSize > 0 && pageSize % SECTOR_SIZE == 0);
+    ASSERT(pageSize <= MAX_PAGE_SIZE);
+    ASSERT(numPhysPages > 0);
+    ASSERT(tlbSize > 0);
+
+    PAGE_SIZE      = pageSize;
+    NUM_PHYS_PAGES = numPhysPages;
+    MEMORY_SIZE    = numPhysPages * pageSize;
+    TLB_SIZE       = tlbSize;
+}
+
 int tlbTotal = 0;
 int tlbHitCount = 0;
 
@@ -180,21 +200,23 @@ MMU::RetrievePageEntry(unsigned vpn, TranslationEntry **entry) const
     ASSERT(entry != nullptr);
 
     if (tlb == nullptr) {
-        // Use a page table; `vpn` is an index in the table.
+        // Use a page table; walk the directory down to the second-level
+        // table that holds `vpn`.
 
         if (vpn >= pageTableSize) {
             DEBUG_CONT('a', "virtual page # %u too large for"
                             " page table size %u!\n",
                        vpn, pageTableSize);
             return ADDRESS_ERROR_EXCEPTION;
-        } else if (!pageTable[vpn].valid) {
-            DEBUG_CONT('a', "virtual page # %u too large for"
-                            " page table size %u!\n",
-                       vpn, pageTableSize);
+        }
+
+        TranslationEntry *table = pageTable[vpn / PAGE_TABLE_ENTRIES];
+        if (table == nullptr || !table[vpn % PAGE_TABLE_ENTRIES].valid) {
+            DEBUG_CONT('a', "virtual page # %u is not mapped!\n", vpn);
             return PAGE_FAULT_EXCEPTION;
         }
 
-        *entry = &pageTable[vpn];
+        *entry = &table[vpn % PAGE_TABLE_ENTRIES];
         return NO_EXCEPTION;
 
     } else {
@@ -264,6 +286,9 @@ MMU::Translate(unsigned virtAddr, unsigned *physAddr,
     TranslationEntry *entry;
     ExceptionType exception = RetrievePageEntry(vpn, &entry);
     if (exception != NO_EXCEPTION) {
+        // A TLB miss is not recorded: the reference is, once it is retried.
+        // The page fault handler records a fault if it has to load the
+        // page.
         return exception;
     }
 
@@ -282,6 +307,10 @@ MMU::Translate(unsigned virtAddr, unsigned *physAddr,
         return BUS_ERROR_EXCEPTION;
     }
 
+    if (pageTrace != nullptr) {
+        pageTrace->Record(currentThread->GetProcess()->GetSpaceId(), vpn, writing, false);
+    }
+
     // Set the `use` and `dirty` flags.
     entry->use = true;
     if (writing) {
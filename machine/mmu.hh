@@ -15,27 +15,43 @@
 
 
 /// Definitions related to the size, and format of user memory.
+///
+/// The geometry of memory can be chosen on the command line (see
+/// `Initialize`), so it is kept in variables that are set once, before the
+/// machine is created, and never change afterwards.
 
-const unsigned PAGE_SIZE = SECTOR_SIZE;  ///< Set the page size equal to the
-                                         ///< disk sector size, for
-                                         ///< simplicity.
-#ifdef SWAP
-const unsigned NUM_PHYS_PAGES = 16;
-#else
-const unsigned NUM_PHYS_PAGES = 256;
-#endif
-
-const unsigned MEMORY_SIZE = NUM_PHYS_PAGES * PAGE_SIZE;
+extern unsigned PAGE_SIZE;       ///< A multiple of the disk sector size, so
+                                 ///< that pages are whole sectors on disk.
+extern unsigned NUM_PHYS_PAGES;
+extern unsigned MEMORY_SIZE;     ///< `NUM_PHYS_PAGES * PAGE_SIZE`.
 
 /// Number of entries in the TLB, if one is present.
 ///
 /// If there is a TLB, it will be small compared to page tables.
+extern unsigned TLB_SIZE;
+
+/// Default geometry.
+const unsigned DEFAULT_PAGE_SIZE = SECTOR_SIZE;
 #ifdef SWAP
-const unsigned TLB_SIZE = 8;
+const unsigned DEFAULT_NUM_PHYS_PAGES = 16;
+const unsigned DEFAULT_TLB_SIZE = 8;
 #else
-const unsigned  TLB_SIZE = 32;
+const unsigned DEFAULT_NUM_PHYS_PAGES = 256;
+const unsigned DEFAULT_TLB_SIZE = 32;
 #endif
 
+/// Largest page size allowed; the swap cache encodes offsets within a page
+/// in 16 bits.
+const unsigned MAX_PAGE_SIZE = 65536;
+
+/// Set the size of pages, in bytes, the number of physical pages and the
+/// number of TLB entries.  Must be called before creating the `MMU`.
+void SetMemoryGeometry(unsigned pageSize, unsigned numPhysPages,
+                       unsigned tlbSize);
+
+/// Number of entries in each second-level page table.
+const unsigned PAGE_TABLE_ENTRIES = 32;
+
 
 /// This class simulates an MMU (memory management unit) that can use either
 /// page tables or a TLB.
@@ -56,6 +72,17 @@ public:
 
     void PrintTLB() const;
 
+    /// Translate an address, and check for alignment.
+    ///
+    /// Set the use and dirty bits in the translation entry appropriately,
+    /// and return an exception code if the translation could not be
+    /// completed.
+    ///
+    /// The kernel uses it to copy whole pages to and from user memory (see
+    /// `userprog/transfer.cc`).
+    ExceptionType Translate(unsigned virtAddr, unsigned *physAddr,
+                            unsigned size, bool writing);
+
     /// Data structures -- all of these are accessible to Nachos kernel code.
     /// “Public” for convenience.
     ///
@@ -69,11 +96,11 @@ public:
     /// NOTE: the hardware translation of virtual addresses in the user
     /// program to physical addresses (relative to the beginning of
     /// `mainMemory`) can be controlled by one of:
-    /// * a traditional linear page table;
+    /// * a two-level page table;
     /// * a software-loaded translation lookaside buffer (tlb) -- a cache of
     ///   mappings of virtual page #'s to physical page #'s.
     ///
-    /// If `tlb` is null, the linear page table is used.
+    /// If `tlb` is null, the page table is used.
     /// If `tlb` is non-null, the Nachos kernel is responsible for managing
     /// the contents of the TLB.  But the kernel can use any data structure
     /// it wants (eg, segmented paging) for handling TLB cache misses.
@@ -88,7 +115,12 @@ public:
     TranslationEntry *tlb;  ///< This pointer should be considered
                             ///< “read-only” to Nachos kernel code.
 
-    TranslationEntry *pageTable;
+    /// The page table is a directory of second-level tables:
+    /// `pageTable[vpn / PAGE_TABLE_ENTRIES]` holds the entry of page `vpn`
+    /// at index `vpn % PAGE_TABLE_ENTRIES`, or is null if none of the pages
+    /// it would cover is mapped.  `pageTableSize` is the number of virtual
+    /// pages.
+    TranslationEntry **pageTable;
     unsigned pageTableSize;
 
 private:
@@ -96,14 +128,6 @@ private:
     /// Retrieve a page entry either from a page table or the TLB.
     ExceptionType RetrievePageEntry(unsigned vpn,
                                     TranslationEntry **entry) const;
-
-    /// Translate an address, and check for alignment.
-    ///
-    /// Set the use and dirty bits in the translation entry appropriately,
-    /// and return an exception code if the translation could not be
-    /// completed.
-    ExceptionType Translate(unsigned virtAddr, unsigned *physAddr,
-                            unsigned size, bool writing);
 };
 
 
@@ -0,0 +1,76 @@
+/// Routines to record page reference traces.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "page_trace.hh"
+#include "mmu.hh"
+#include "threads/system.hh"
+
+
+PageTrace::PageTrace(const char *name)
+{
+    ASSERT(name != nullptr);
+
+    file = fopen(name, "wb");
+    if (file == nullptr) {
+        fprintf(stderr, "ERROR: file `%s` could not be opened.\n", name);
+        ASSERT(false);
+    }
+
+    pageTraceHeader header;
+    header.magic        = PAGE_TRACE_MAGIC;
+    header.pageSize     = PAGE_SIZE;
+    header.numPhysPages = NUM_PHYS_PAGES;
+    header.reserved     = 0;
+    fwrite(&header, sizeof header, 1, file);
+
+    buffer = new pageTraceRecord [PAGE_TRACE_BUFFER_SIZE];
+    used = 0;
+}
+
+PageTrace::~PageTrace()
+{
+    Flush();
+    fclose(file);
+    delete [] buffer;
+}
+
+void
+PageTrace::Record(int spaceId, unsigned vpn, bool writing, bool fault)
+{
+    uint8_t flags = (writing ? PAGE_TRACE_WRITE : 0)
+                  | (fault ? PAGE_TRACE_FAULT : 0);
+
+    // Consecutive references to the same page, like the instructions of a
+    // loop, take a single record.
+    if (used > 0 && !fault) {
+        pageTraceRecord *last = &buffer[used - 1];
+        if (last->vpn == vpn && last->spaceId == spaceId
+              && last->flags == flags && last->count < UINT8_MAX) {
+            last->count++;
+            return;
+        }
+    }
+
+    if (used == PAGE_TRACE_BUFFER_SIZE) {
+        Flush();
+    }
+    pageTraceRecord *r = &buffer[used++];
+    r->tick    = (uint32_t) stats->totalTicks;
+    r->vpn     = vpn;
+    r->spaceId = spaceId;
+    r->flags   = flags;
+    r->count   = 1;
+}
+
+void
+PageTrace::Flush()
+{
+    if (used > 0) {
+        fwrite(buffer, sizeof *buffer, used, file);
+        used = 0;
+    }
+}
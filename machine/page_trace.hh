@@ -0,0 +1,48 @@
+/// Recording of page reference traces.
+///
+/// With the `-tr` option, every translation done by the MMU, and every page
+/// loaded by a page fault, is appended to a trace file, in the format
+/// described in `bin/page_trace.h`, which the `pagesim` tool can replay
+/// against several replacement policies and memory sizes.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_PAGETRACE__HH
+#define NACHOS_MACHINE_PAGETRACE__HH
+
+
+#include "bin/page_trace.h"
+
+#include <stdio.h>
+
+
+/// Number of records kept in memory before writing them to the file.
+const unsigned PAGE_TRACE_BUFFER_SIZE = 4096;
+
+class PageTrace {
+public:
+
+    /// Create the file `name`, and write the header of the trace.
+    PageTrace(const char *name);
+
+    /// Write the records still in memory, and close the file.
+    ~PageTrace();
+
+    /// Record a reference to page `vpn` of process `spaceId`.  `fault`
+    /// tells whether the page had to be loaded into memory for it.
+    void Record(int spaceId, unsigned vpn, bool writing, bool fault);
+
+private:
+
+    void Flush();
+
+    FILE *file;
+
+    pageTraceRecord *buffer;
+    unsigned used;
+};
+
+
+#endif
@@ -20,7 +20,15 @@ Statistics::Statistics()
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
+    numConsoleReads = numConsoleWrites = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numCleanEvictions = numDirtyEvictions = numPagesCleaned = 0;
+    numPagesPrefetched = numTextPagesShared = 0;
+    numFramesZeroed = numZeroFillsSkipped = 0;
+    numSwapCacheStores = numSameFilledPages = numSwapCacheRejects = 0;
+    numSwapCacheSpills = numSwapCacheHits = numSwapCacheMisses = 0;
+    swapCacheBytesIn = swapCacheBytesOut = 0;
+    numMessagesSent = numMessagePagesRemapped = numMessageBytesCopied = 0;
 #ifdef DFS_TICKS_FIX
     tickResets = 0;
 #endif
@@ -41,9 +49,25 @@ Statistics::Print()
     printf("Ticks: total %lu, idle %lu, system %lu, user %lu\n",
            totalTicks, idleTicks, systemTicks, userTicks);
     printf("Disk I/O: reads %lu, writes %lu\n", numDiskReads, numDiskWrites);
-    printf("Console I/O: reads %lu, writes %lu\n",
-           numConsoleCharsRead, numConsoleCharsWritten);
-    printf("Paging: faults %lu\n", numPageFaults);
+    printf("Console I/O: reads %lu (%lu transfers), writes %lu"
+           " (%lu transfers)\n",
+           numConsoleCharsRead, numConsoleReads,
+           numConsoleCharsWritten, numConsoleWrites);
+    printf("Paging: faults %lu, evictions %lu (clean %lu, dirty %lu),"
+           " cleaned %lu, prefetched %lu, shared text %lu,"
+           " zeroed ahead %lu (used %lu)\n",
+           numPageFaults, numCleanEvictions + numDirtyEvictions,
+           numCleanEvictions, numDirtyEvictions, numPagesCleaned,
+           numPagesPrefetched, numTextPagesShared,
+           numFramesZeroed, numZeroFillsSkipped);
+    printf("Swap cache: stored %lu (same-filled %lu), rejected %lu,"
+           " spilled %lu, hits %lu, misses %lu, compression ratio %.2f\n",
+           numSwapCacheStores, numSameFilledPages, numSwapCacheRejects,
+           numSwapCacheSpills, numSwapCacheHits, numSwapCacheMisses,
+           swapCacheBytesOut == 0 ? 0.0
+                                  : (double) swapCacheBytesIn / swapCacheBytesOut);
+    printf("Messages: sent %lu, pages remapped %lu, bytes copied %lu\n",
+           numMessagesSent, numMessagePagesRemapped, numMessageBytesCopied);
     printf("Network I/O: packets received %lu, sent %lu\n",
            numPacketsRecvd, numPacketsSent);
 }
@@ -44,9 +44,67 @@ public:
     /// Number of characters written to the display.
     unsigned long numConsoleCharsWritten;
 
+    /// Number of blocks read from the keyboard and written to the display,
+    /// each one a single interrupt.
+    unsigned long numConsoleReads;
+    unsigned long numConsoleWrites;
+
     /// Number of virtual memory page faults.
     unsigned long numPageFaults;
 
+    /// Number of evicted pages that were clean, and could be dropped
+    /// without writing them to swap.
+    unsigned long numCleanEvictions;
+
+    /// Number of evicted pages that were dirty, and had to be written to
+    /// swap first.
+    unsigned long numDirtyEvictions;
+
+    /// Number of dirty pages written to swap by the page daemon ahead of
+    /// their eviction.
+    unsigned long numPagesCleaned;
+
+    /// Number of pages loaded ahead of their first reference, because the
+    /// page faults before them were sequential.
+    unsigned long numPagesPrefetched;
+
+    /// Number of code pages mapped from the text cache, instead of being
+    /// read from the executable.
+    unsigned long numTextPagesShared;
+
+    /// Number of free frames zeroed by the zero daemon, and number of times
+    /// a page was loaded into one of them and did not have to be cleared.
+    unsigned long numFramesZeroed;
+    unsigned long numZeroFillsSkipped;
+
+    /// Number of pages written to swap that were kept in the compressed
+    /// swap cache, and how many of them were filled with a single byte.
+    unsigned long numSwapCacheStores;
+    unsigned long numSameFilledPages;
+
+    /// Number of pages written to swap that did not compress well enough
+    /// for the swap cache.
+    unsigned long numSwapCacheRejects;
+
+    /// Number of cached pages written to the swap file to make room.
+    unsigned long numSwapCacheSpills;
+
+    /// Number of swap reads served by the swap cache, and by the swap file.
+    unsigned long numSwapCacheHits;
+    unsigned long numSwapCacheMisses;
+
+    /// Bytes of the pages stored in the swap cache, before and after
+    /// compression.
+    unsigned long swapCacheBytesIn;
+    unsigned long swapCacheBytesOut;
+
+    /// Number of messages sent through message queues, number of their
+    /// pages moved from one page table to another instead of copied (counted
+    /// once when sent and once when received), and bytes copied.
+    unsigned long numMessagesSent;
+    unsigned long numMessagePagesRemapped;
+    unsigned long numMessageBytesCopied;
+
     /// Number of packets sent over the network.
     unsigned long numPacketsSent;
 
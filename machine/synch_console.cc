@@ -55,28 +55,88 @@ SynchConsole::~SynchConsole()
     delete lockWrite;
 }
 
-/// Read the contents of a console into a buffer.  Return only after the
-/// data has been read.
+/// Read a character from the console.  Return only after there is one.
 char
 SynchConsole::ReadConsole()
 {
-    lockRead->Acquire();  // only one thread can be reading of the console
-    readAvail->P(); //wait until there is something to be read
-    char character = console->GetChar();
-    lockRead->Release();
-
+    char character;
+    Read(&character, 1);
     return character;
 }
 
-/// Write the contents of a buffer in the console.  Return only
-/// after the data has been written.
+/// Write a character in the console.  Return only after it has been
+/// written.
 ///
 /// `ch` is the character to be written.
 void
 SynchConsole::WriteConsole(char ch)
 {
+    Write(&ch, 1);
+}
+
+/// Read the characters available in the console into a buffer.  Return only
+/// after there has been at least one.
+///
+/// The device signals once for every block that arrives, so the semaphore
+/// can be ahead of the characters that are left: check for them first, and
+/// only wait if there are none.
+unsigned
+SynchConsole::Read(char *buffer, unsigned size)
+{
+    ASSERT(buffer != nullptr);
+    ASSERT(size > 0);
+
+    lockRead->Acquire();  // only one thread can be reading of the console
+    unsigned count;
+    while ((count = console->GetBlock(buffer, size)) == 0) {
+        readAvail->P();  // wait until there is something to be read
+    }
+    lockRead->Release();
+
+    return count;
+}
+
+/// Read a line of the console into a buffer.  Return only after the
+/// newline, or `size` characters, have been read.
+unsigned
+SynchConsole::ReadLine(char *buffer, unsigned size)
+{
+    ASSERT(buffer != nullptr);
+    ASSERT(size > 0);
+
+    lockRead->Acquire();  // the line must not be interleaved with others
+    unsigned count = 0;
+    while (count < size) {
+        if (console->GetBlock(&buffer[count], 1) == 0) {
+            readAvail->P();
+            continue;
+        }
+        if (buffer[count++] == '\n') {
+            break;
+        }
+    }
+    lockRead->Release();
+
+    return count;
+}
+
+/// Write the contents of a buffer in the console.  Return only after the
+/// data has been written.
+///
+/// The buffer goes to the device in blocks of `CONSOLE_BLOCK_SIZE`, each
+/// one a single host write and a single interrupt.
+void
+SynchConsole::Write(const char *buffer, unsigned size)
+{
+    ASSERT(buffer != nullptr);
+
     lockWrite->Acquire();  // not only one disk I/O at a time: en este caso un hilo queriendo escribir no deberia bloquear a un hilo queriendo leer.
-    console->PutChar(ch);
-    writeDone->P();   // wait for interrupt
+    while (size > 0) {
+        unsigned block = size < CONSOLE_BLOCK_SIZE ? size : CONSOLE_BLOCK_SIZE;
+        console->PutBlock(buffer, block);
+        writeDone->P();   // wait for interrupt
+        buffer += block;
+        size   -= block;
+    }
     lockWrite->Release();
 }
@@ -16,6 +16,17 @@ public:
     char ReadConsole();
     void WriteConsole(char ch);
 
+    /// Wait until there is input, and move up to `size` characters of it
+    /// into `buffer`.  Return how many.
+    unsigned Read(char *buffer, unsigned size);
+
+    /// Read characters into `buffer` until a newline, which is kept, or
+    /// until there are `size` of them.  Return how many.
+    unsigned ReadLine(char *buffer, unsigned size);
+
+    /// Write the `size` characters of `buffer`, a block at a time.
+    void Write(const char *buffer, unsigned size);
+
     void ReadAvailSynch();
     void WriteDoneSynch();
 
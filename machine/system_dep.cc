@@ -34,6 +34,7 @@ extern "C" {
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/file.h>
+#include <sys/stat.h>
 #include <sys/un.h>
 #include <sys/mman.h>
 #ifdef HOST_i386
@@ -181,6 +182,26 @@ Tell(int fd)
 #endif
 }
 
+/// Identify an open file, and tell when it was last modified.
+///
+/// Abort on error.
+void
+Stat(int fd, unsigned long long *device, unsigned long long *inode,
+     unsigned long long *modified)
+{
+    ASSERT(device != nullptr);
+    ASSERT(inode != nullptr);
+    ASSERT(modified != nullptr);
+
+    struct stat status;
+    int retVal = fstat(fd, &status);
+    ASSERT(retVal >= 0);
+    *device   = status.st_dev;
+    *inode    = status.st_ino;
+    *modified = status.st_mtim.tv_sec * 1000000000ULL
+                + status.st_mtim.tv_nsec;
+}
+
 /// Close a file.
 ///
 /// Abort on error.
@@ -41,6 +41,11 @@ namespace SystemDep {
 
     int Tell(int fd);
 
+    /// The device and i-node of the file open as `fd`, and the time it was
+    /// last modified, in nanoseconds.
+    void Stat(int fd, unsigned long long *device, unsigned long long *inode,
+              unsigned long long *modified);
+
     void Close(int fd);
 
     bool Unlink(const char *name);
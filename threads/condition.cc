@@ -58,6 +58,7 @@ Condition::Wait()
 
     conditionLock->Release(); // Yielding thread...
     new_semaphore->P(); // Go to sleep
+    delete new_semaphore;  // `Signal` took it out of the queue.
 
     conditionLock->Acquire();
 }
@@ -67,7 +68,9 @@ Condition::Signal()
 {
     ASSERT(conditionLock->IsHeldByCurrentThread());
     if(queue->IsEmpty()) return;
-    Semaphore* semaphore = queue->Head();
+    // Each waiter is woken only once, so that a later `Signal` goes to the
+    // next one.
+    Semaphore* semaphore = queue->Pop();
     semaphore->V();
 }
 
@@ -13,6 +13,8 @@
 ///     nachos [-d <debugflags>] [-do <debugopts>] [-p]
 ///            [-rs <random seed #>] [-z] [-tt]
 ///            [-s] [-x <nachos file>] [-tc <consoleIn> <consoleOut>]
+///            [-ps <page size>] [-np <physical pages>] [-tlb <tlb size>]
+///            [-tr <trace file>] [-sc] [-scf <table file>] [-st]
 ///            [-f] [-cp <unix file> <nachos file>] [-pr <nachos file>]
 ///            [-rm <nachos file>] [-ls] [-D] [-c] [-tf]
 ///            [-n <network reliability>] [-id <machine id>]
@@ -41,6 +43,16 @@
 /// * `-s`  -- causes user programs to be executed in single-step mode.
 /// * `-x`  -- runs a user program.
 /// * `-tc` -- tests the console.
+/// * `-ps` -- sets the page size, in bytes; a multiple of the sector size.
+/// * `-np` -- sets the number of physical pages.
+/// * `-tlb` -- sets the number of TLB entries.
+/// * `-tr` -- records every page reference in a trace file, for
+///            `bin/pagesim`, and every page fault that loaded a page; TLB
+///            misses on pages in memory are not faults.
+/// * `-sc` -- counts the system calls of every process, and prints a table
+///            of their counts, ticks and bytes when the machine halts.
+/// * `-scf` -- writes that table to a file, as tab separated values.
+/// * `-st` -- logs every system call to standard error as it returns.
 ///
 /// *FILESYS* options
 /// -----------------
@@ -47,12 +47,14 @@ General:\n\
   Nachos release: %s %s.\n\
   Option definitions: %s\n",
       PROGRAM, VERSION, OPTIONS);
+#ifdef USER_PROGRAM
     printf("\n\
 Memory:\n\
   Page size: %d bytes.\n\
   Number of pages: %d.\n\
   Number of TLB entries: %d.\n\
   Memory size: %d bytes.\n", PAGE_SIZE, NUM_PHYS_PAGES, TLB_SIZE, MEMORY_SIZE);
+#endif
     printf("\n\
 Disk:\n\
   Sector size: %d bytes.\n\
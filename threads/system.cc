@@ -33,6 +33,11 @@ Timer *timer;                 ///< The hardware timer device, for invoking
                               ///< context switches.
 #ifdef SWAP
 CoreMapEntry* coreMap;
+Lock *coreMapLock;
+PageDaemon *pageDaemon;
+SwapArea *swapArea;
+TextCache *textCache;
+Table<SharedSegment *> *sharedSegments;
 #endif
 // 2007, Jose Miguel Santos Espino
 PreemptiveScheduler *preemptiveScheduler = nullptr;
@@ -54,6 +59,12 @@ Lock* filesysCreateLock;
 Machine *machine;  ///< User program memory and registers.
 Bitmap *addressesBitMap;        ///< The bitmap to search and allocate processes into memory,
                               ///< this is used for the implementation of multiprgramming.
+ZeroDaemon *zeroDaemon;         ///< Zeroes free frames while the CPU is idle.
+IoWorkers *ioWorkers;           ///< Threads serving the rings of `IoSetup`.
+PageTrace *pageTrace;           ///< Records page references, with `-tr`.
+SyscallStats *syscallStats;     ///< Counts system calls, with `-sc`.
+MessageQueues *messageQueues;   ///< Queues of `MsgSend` and `MsgRecv`.
+Futexes *futexes;               ///< Threads in `FutexWait`.
 Table<Thread*> *runningProcesses;
 SynchConsole* consoleSys;
 #endif
@@ -70,6 +81,10 @@ unsigned fifo_counter;
 unsigned references_done;
 #endif
 
+#if defined(PRPOLICY_CLOCK) || defined(PRPOLICY_WSCLOCK)
+unsigned clock_hand;
+#endif
+
 
 // External definition, to allow us to take a pointer to this function.
 extern void Cleanup();
@@ -157,6 +172,13 @@ Initialize(int argc, char **argv)
 
 #ifdef USER_PROGRAM
     bool debugUserProg = false;  // Single step user program.
+    unsigned pageSize = DEFAULT_PAGE_SIZE;
+    unsigned numPhysPages = DEFAULT_NUM_PHYS_PAGES;
+    unsigned tlbSize = DEFAULT_TLB_SIZE;
+    const char *traceName = nullptr;  // Page reference trace.
+    bool countSyscalls = false;  // Print a table of system calls.
+    const char *syscallsName = nullptr;  // File for the table.
+    bool traceSyscalls = false;  // Log every system call.
 #endif
 #ifdef FILESYS_NEEDED
     bool format = false;  // Format disk.
@@ -200,6 +222,30 @@ Initialize(int argc, char **argv)
 #ifdef USER_PROGRAM
         if (!strcmp(*argv, "-s")) {
             debugUserProg = true;
+        } else if (!strcmp(*argv, "-ps")) {
+            ASSERT(argc > 1);
+            pageSize = atoi(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-np")) {
+            ASSERT(argc > 1);
+            numPhysPages = atoi(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-tlb")) {
+            ASSERT(argc > 1);
+            tlbSize = atoi(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-tr")) {
+            ASSERT(argc > 1);
+            traceName = *(argv + 1);
+            argCount = 2;
+        } else if (!strcmp(*argv, "-sc")) {
+            countSyscalls = true;
+        } else if (!strcmp(*argv, "-scf")) {
+            ASSERT(argc > 1);
+            syscallsName = *(argv + 1);
+            argCount = 2;
+        } else if (!strcmp(*argv, "-st")) {
+            traceSyscalls = true;
         }
 #endif
 #ifdef FILESYS_NEEDED
@@ -253,8 +299,18 @@ Initialize(int argc, char **argv)
 
 #ifdef USER_PROGRAM
     Debugger *d = debugUserProg ? new Debugger : nullptr;
+    SetMemoryGeometry(pageSize, numPhysPages, tlbSize);
+    pageTrace = traceName != nullptr ? new PageTrace(traceName) : nullptr;
+    syscallStats = countSyscalls || syscallsName != nullptr || traceSyscalls
+                     ? new SyscallStats(countSyscalls, syscallsName,
+                                        traceSyscalls)
+                     : nullptr;
     machine = new Machine(d);  // This must come first.
     addressesBitMap = new Bitmap(NUM_PHYS_PAGES);
+    zeroDaemon = new ZeroDaemon();
+    ioWorkers = new IoWorkers();
+    messageQueues = new MessageQueues();
+    futexes = new Futexes();
     SetExceptionHandlers();
 
     consoleSys = new SynchConsole(nullptr, nullptr);
@@ -266,8 +322,14 @@ Initialize(int argc, char **argv)
         coreMap[i] = new struct _coreMapEntry;
         coreMap[i]->spaceId = 0;
         coreMap[i]->virtualPage = 0;
+        coreMap[i]->segment = nullptr;
+        coreMap[i]->refCount = 0;
+        coreMap[i]->inTransit = false;
 #ifdef PRPOLICY_LRU
         coreMap[i]->last_use_counter = 0;
+#endif
+#ifdef PRPOLICY_WSCLOCK
+        coreMap[i]->last_use_tick = 0;
 #endif
     }
 #endif
@@ -283,6 +345,7 @@ Initialize(int argc, char **argv)
         openFilesTable[i]->removed = false;
         openFilesTable[i]->removing = false;
         openFilesTable[i]->count = 0;
+        openFilesTable[i]->version = 0;
     }
     filesysCreateLock = new Lock("Create Lock");
 #endif
@@ -295,6 +358,14 @@ Initialize(int argc, char **argv)
     postOffice = new PostOffice(netname, rely, 10);
 #endif
 
+#ifdef SWAP
+    coreMapLock = new Lock("core map lock");
+    pageDaemon = new PageDaemon();
+    swapArea = new SwapArea(SWAP_FILE_NAME, NUM_SWAP_SLOTS);
+    textCache = new TextCache();
+    sharedSegments = new Table<SharedSegment *>;
+#endif
+
 #ifdef PRPOLICY_FIFO
     fifo_counter = 0;
 #endif
@@ -302,6 +373,10 @@ Initialize(int argc, char **argv)
 #ifdef PRPOLICY_LRU
     references_done = 0;
 #endif
+
+#if defined(PRPOLICY_CLOCK) || defined(PRPOLICY_WSCLOCK)
+    clock_hand = 0;
+#endif
 }
 
 /// Nachos is halting.  De-allocate global data structures.
@@ -317,11 +392,22 @@ Cleanup()
 
 #ifdef USER_PROGRAM
     delete runningProcesses;
+    delete zeroDaemon;
+    delete ioWorkers;
+    delete messageQueues;
+    delete futexes;
+    delete pageTrace;
+    delete syscallStats;
     delete addressesBitMap;
     delete machine;
 #endif
 
 #ifdef SWAP
+    delete pageDaemon;
+    delete coreMapLock;
+    delete swapArea;
+    delete textCache;
+    delete sharedSegments;
     for(unsigned i = 0; i < NUM_PHYS_PAGES; ++i) {
         delete coreMap[i];
     }
@@ -27,16 +27,38 @@ extern void Initialize(int argc, char **argv);
 extern void Cleanup();
 
 #ifdef SWAP
+class SharedSegment;
+
 typedef struct _coreMapEntry{
     SpaceId spaceId;
     unsigned virtualPage;
+    SharedSegment *segment;     // the shared memory segment the page belongs to, if any
+    unsigned refCount;          // number of address spaces mapping the frame, more than one after a Fork
+                                // or for shared code pages; spaceId is any one of them.  It is 0 for a
+                                // code page that stays in the text cache after its last process exited
+    bool inTransit;             // the frame holds a page of a message, out of every page table, and
+                                // must not be evicted until it is received
 #ifdef PRPOLICY_LRU
     unsigned last_use_counter;  // this will represent the last recently use page.
                                 // to search for the victim we will search directly for the minimun value of the array
 #endif
+#ifdef PRPOLICY_WSCLOCK
+    unsigned long last_use_tick;  // virtual time of the last sweep that found the page referenced,
+                                  // the page is in the working set while this is recent enough
+#endif
 }* CoreMapEntry;
 
 extern CoreMapEntry* coreMap;
+
+#include "vmem/page_daemon.hh"
+#include "vmem/swap_area.hh"
+#include "vmem/text_cache.hh"
+#include "vmem/shared_segment.hh"
+extern Lock *coreMapLock;        ///< Serializes page faults and page-outs.
+extern PageDaemon *pageDaemon;   ///< Keeps a pool of free frames.
+extern SwapArea *swapArea;       ///< Backing store of evicted pages.
+extern TextCache *textCache;     ///< Code pages shared between processes.
+extern Table<SharedSegment *> *sharedSegments;  ///< Shared memory segments, by id.
 #endif
 
 #ifdef PRPOLICY_FIFO
@@ -47,6 +69,10 @@ extern unsigned fifo_counter;
 extern unsigned references_done;
 #endif
 
+#if defined(PRPOLICY_CLOCK) || defined(PRPOLICY_WSCLOCK)
+extern unsigned clock_hand;  // next frame of the core map to be inspected by the clock
+#endif
+
 extern Thread *currentThread;        ///< The thread holding the CPU.
 extern Thread *threadToBeDestroyed;  ///< The thread that just finished.
 extern Scheduler *scheduler;         ///< The ready list.
@@ -59,9 +85,23 @@ extern const unsigned NUMBER_OF_TRIES;
 #ifdef USER_PROGRAM
 #include "machine/machine.hh"
 #include "machine/synch_console.hh"
+#include "userprog/zero_daemon.hh"
+#include "userprog/io_ring.hh"
+#include "userprog/pipe.hh"
+#include "machine/page_trace.hh"
+#include "userprog/syscall_stats.hh"
+#include "userprog/message_queue.hh"
+#include "userprog/futex.hh"
 
 extern Machine *machine;  // User program memory and registers.
 extern Bitmap* addressesBitMap;       ///< the addresses bit map
+extern ZeroDaemon *zeroDaemon;        ///< Zeroes free frames when idle.
+extern IoWorkers *ioWorkers;          ///< Carry out asynchronous I/O.
+extern PageTrace *pageTrace;          ///< Null unless references are traced.
+extern SyscallStats *syscallStats;    ///< Null unless system calls are
+                                      ///< counted or traced.
+extern MessageQueues *messageQueues;  ///< Queues of `MsgSend`, by key.
+extern Futexes *futexes;              ///< Threads in `FutexWait`.
 extern Table<Thread*> *runningProcesses;
 extern SynchConsole* consoleSys;
 #endif
@@ -82,6 +122,7 @@ typedef struct _openFileEntry {
     Lock* removeLock;
     Lock* closeLock;
     SpaceId removerSpaceId;
+    unsigned long long version;  ///< Bumped by every write, see `FileStamp`.
 }* OpenFileEntry;
 
 extern OpenFileEntry* openFilesTable;
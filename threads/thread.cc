@@ -21,6 +21,7 @@
 #include "switch.h"
 #include "system.hh"
 #include "lock.hh"
+#include "semaphore.hh"
 #include "channel.hh"
 
 #include <inttypes.h>
@@ -57,7 +58,13 @@ Thread::Thread(const char *threadName, bool isJoinable, size_t priorityParam)
     DEBUG('t',"The thread created is:%s\n", name);
 #ifdef USER_PROGRAM
     space    = nullptr;
+    ioRing   = nullptr;
     openedFilesTable = new Table<OpenFile*>;
+    pipeEnds = nullptr;
+    process  = this;
+    numUserThreads   = 0;
+    userThreadExited = nullptr;
+    userStack = 0;
 
     openedFilesTable->Add(nullptr); //for console input
     openedFilesTable->Add(nullptr); //for console output
@@ -91,11 +98,19 @@ Thread::~Thread()
     }
 
 #ifdef USER_PROGRAM
-    if(space != nullptr) delete space;
+    // Other threads of the process only borrow the address space.
+    if(space != nullptr && process == this) delete space;
+    delete userThreadExited;
     for(int i = 0; openedFilesTable->HasKey(i); ++i) {
         delete openedFilesTable->Get(i);
     }
     delete openedFilesTable;
+    if(pipeEnds != nullptr) {
+        for(unsigned i = 0; i < Table<OpenFile*>::SIZE; ++i) {
+            delete pipeEnds[i];
+        }
+        delete [] pipeEnds;
+    }
 #endif
 
     if(joinable) delete joinChannel;
@@ -219,6 +234,10 @@ Thread::Finish(int st)
         if(spaceId == 0) { // If the space Id is the main thread we need to halt the nachos
             printf("Finishing thread main and the console still running!\nGetting the interrupt handler ready.\n");
             consoleRunning = true;
+            zeroDaemon->Stop();
+        #ifdef SWAP
+            pageDaemon->Stop();
+        #endif
         }
     #endif
 
@@ -396,11 +415,81 @@ Thread::RestoreUserState()
     for (unsigned i = 0; i < NUM_TOTAL_REGS; i++) {
         machine->WriteRegister(i, userRegisters[i]);
     }
+    machine->ClearLink();  // Another thread ran in between.
 }
 
 Table<OpenFile*>*
 Thread::GetOpenedFilesTable() {
-    return openedFilesTable;
+    return process->openedFilesTable;
+}
+
+PipeEnd *
+Thread::GetPipeEnd(int fid)
+{
+    if(process != this)
+        return process->GetPipeEnd(fid);
+    if(pipeEnds == nullptr || fid < 0 || (unsigned) fid >= Table<OpenFile*>::SIZE)
+        return nullptr;
+    return pipeEnds[fid];
+}
+
+void
+Thread::SetPipeEnd(int fid, PipeEnd *end)
+{
+    ASSERT(fid >= 0 && (unsigned) fid < Table<OpenFile*>::SIZE);
+
+    if(process != this) {
+        process->SetPipeEnd(fid, end);
+        return;
+    }
+
+    if(pipeEnds == nullptr) {
+        pipeEnds = new PipeEnd *[Table<OpenFile*>::SIZE];
+        for(unsigned i = 0; i < Table<OpenFile*>::SIZE; ++i)
+            pipeEnds[i] = nullptr;
+    }
+    pipeEnds[fid] = end;
+}
+
+void
+Thread::SetProcess(Thread *main)
+{
+    ASSERT(main != nullptr && main->process == main);
+    ASSERT(status == JUST_CREATED);
+
+    process = main;
+    space   = main->space;
+    if(main->userThreadExited == nullptr)
+        main->userThreadExited = new Semaphore("user thread exited", 0);
+    main->numUserThreads++;
+}
+
+Thread *
+Thread::GetProcess()
+{
+    return process;
+}
+
+void
+Thread::ExitUserThread()
+{
+    ASSERT(this == currentThread && process != this);
+
+    space->ReleaseThreadStack(userStack);
+    process->numUserThreads--;
+    process->userThreadExited->V();
+}
+
+void
+Thread::WaitForUserThreads()
+{
+    ASSERT(this == currentThread && process == this);
+
+    while(numUserThreads > 0) {
+        DEBUG('t', "Thread \"%s\" waits for %u threads of its process\n",
+              name, numUserThreads);
+        userThreadExited->P();
+    }
 }
 
 #endif
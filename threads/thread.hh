@@ -47,6 +47,10 @@ class Channel;
 #include "machine/machine.hh"
 #include "userprog/address_space.hh"
 #include "lib/table.hh"
+
+class IoRing;
+class PipeEnd;
+class Semaphore;
 #endif
 
 #include <stdint.h>
@@ -182,8 +186,43 @@ private:
     int userRegisters[NUM_TOTAL_REGS];
     Table<OpenFile*> *openedFilesTable;    //tabla de los archivos abiertos del hilo
 
+    /// Pipe ends open in this process, indexed by their ids, which are
+    /// taken from `openedFilesTable` with no file in it.  Null until the
+    /// first one.
+    PipeEnd **pipeEnds;
+
+    /// Main thread of the process this thread runs in: the thread itself,
+    /// unless it was created by `ThreadCreate`.  Open files and pipe ends
+    /// belong to the main thread.
+    Thread *process;
+
+    /// In a main thread, how many threads of its process have not exited,
+    /// and a semaphore they signal when they do, null until the first one.
+    unsigned numUserThreads;
+    Semaphore *userThreadExited;
+
 public:
 
+    /// Top of the user stack of a thread created by `ThreadCreate`, or 0.
+    int userStack;
+
+    /// Make this thread, which must not have started yet, one more thread
+    /// of the process of `main`.
+    void SetProcess(Thread *main);
+
+    /// Return the main thread of the process this thread runs in.
+    Thread *GetProcess();
+
+    /// Called from a thread other than the main one when it exits.
+    void ExitUserThread();
+
+    /// Called from the main thread when it exits: wait until every other
+    /// thread of its process has exited too.
+    void WaitForUserThreads();
+
+    /// Ring registered with `IoSetup`, or null.
+    IoRing *ioRing;
+
     // Save user-level register state.
     void SaveUserState();
 
@@ -194,6 +233,13 @@ public:
     AddressSpace *space;
 
     Table<OpenFile*>* GetOpenedFilesTable();
+
+    /// Return the pipe end open as `fid`, or null if it is something else.
+    PipeEnd *GetPipeEnd(int fid);
+
+    /// Make `end` the pipe end open as `fid`.  It can be null, to forget
+    /// the previous one.
+    void SetPipeEnd(int fid, PipeEnd *end);
 #endif
 #ifdef FILESYS
     Channel* GetRemoveChannel();
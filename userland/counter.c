@@ -0,0 +1,60 @@
+/// Test program for threads within a process.
+///
+/// Several threads add to a shared counter under a lock, and yield the CPU
+/// while they hold it, so that the others find it taken and sleep on it
+/// with `FutexWait`.  The lock itself is built on the `LL` and `SC`
+/// instructions.
+
+
+#include "syscall.h"
+#include "lib.h"
+
+
+#define THREADS  3
+#define ROUNDS   50
+
+static int lock = 0;
+static int counter = 0;
+static int numbers[THREADS];
+
+static int
+add(void *arg)
+{
+    int i;
+
+    for (i = 0; i < ROUNDS; i++) {
+        acquire(&lock);
+        int seen = counter;
+        Yield();  // Anyone else trying now has to wait.
+        counter = seen + 1;
+        release(&lock);
+    }
+    return *(int *) arg;
+}
+
+int
+main(void)
+{
+    SpaceId ids[THREADS];
+    int i;
+    char c[12];
+
+    for (i = 0; i < THREADS; i++) {
+        numbers[i] = i + 1;
+        ids[i] = ThreadCreate(add, &numbers[i], 1);
+        if (ids[i] < 0) {
+            putss("Cannot create a thread.");
+            return -1;
+        }
+    }
+    for (i = 0; i < THREADS; i++) {
+        Join(ids[i]);
+    }
+
+    putss("The counter is: ");
+    itoa(counter, c);
+    putss(c);
+
+    // Should be `THREADS * ROUNDS`, 150; less means updates were lost.
+    return counter;
+}
@@ -0,0 +1,57 @@
+/// Test program for threads that are never joined.
+///
+/// The main thread creates them and returns right away.  The process, and
+/// the memory the threads use, must last until every one of them is done.
+
+
+#include "syscall.h"
+#include "lib.h"
+
+
+#define THREADS  3
+#define ROUNDS   20
+
+static int lock = 0;
+static int numbers[THREADS];
+
+static void
+say(const char *s)
+{
+    Write(s, strlen(s), CONSOLE_OUTPUT);
+}
+
+static int
+work(void *arg)
+{
+    int i;
+    char c[12];
+
+    // Give the main thread plenty of chances to exit first.
+    for (i = 0; i < ROUNDS; i++) {
+        Yield();
+    }
+
+    acquire(&lock);
+    itoa(*(int *) arg, c);
+    say("Thread ");
+    say(c);
+    say(" done.\n");
+    release(&lock);
+
+    return 0;
+}
+
+int
+main(void)
+{
+    int i;
+
+    for (i = 0; i < THREADS; i++) {
+        numbers[i] = i + 1;
+        if (ThreadCreate(work, &numbers[i], 0) < 0) {
+            putss("Cannot create a thread.");
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -6,14 +6,13 @@
 int
 PrintString(const char *s)
 {
-    unsigned len = strlen(s);
-    return Write(s, len, CONSOLE_OUTPUT);
+    return bputs(s, bstdout);
 }
 
 int
 PrintChar(char c)
 {
-    return Write(&c, 1, CONSOLE_OUTPUT);
+    return bputc(c, bstdout);
 }
 
 int
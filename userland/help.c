@@ -38,42 +38,42 @@
 int
 main(int argc, char *argv[])
 {
-    Write(HELP_HELP,    sizeof(HELP_HELP)    - 1, CONSOLE_OUTPUT);
+    bputs(HELP_HELP, bstdout);
 
-    Write(LS_HELP,      sizeof(LS_HELP)      - 1, CONSOLE_OUTPUT);
+    bputs(LS_HELP, bstdout);
 
-    Write(CD_HELP,      sizeof(CD_HELP)      - 1, CONSOLE_OUTPUT);
-    Write(CD_USE,      sizeof(CD_USE)      - 1, CONSOLE_OUTPUT);
+    bputs(CD_HELP, bstdout);
+    bputs(CD_USE, bstdout);
 
-    Write(TOUCH_HELP,   sizeof(TOUCH_HELP)   - 1, CONSOLE_OUTPUT);
-    Write(TOUCH_USE,   sizeof(TOUCH_USE)   - 1, CONSOLE_OUTPUT);
+    bputs(TOUCH_HELP, bstdout);
+    bputs(TOUCH_USE, bstdout);
 
-    Write(WRITE_HELP,   sizeof(WRITE_HELP)   - 1, CONSOLE_OUTPUT);
-    Write(WRITE_USE,   sizeof(WRITE_USE)   - 1, CONSOLE_OUTPUT);
+    bputs(WRITE_HELP, bstdout);
+    bputs(WRITE_USE, bstdout);
 
-    Write(CP_HELP,   sizeof(CP_HELP)   - 1, CONSOLE_OUTPUT);
-    Write(CP_USE,   sizeof(CP_USE)   - 1, CONSOLE_OUTPUT);
+    bputs(CP_HELP, bstdout);
+    bputs(CP_USE, bstdout);
 
-    Write(CAT_HELP,     sizeof(CAT_HELP)     - 1, CONSOLE_OUTPUT);
-    Write(CAT_USE,     sizeof(CAT_USE)     - 1, CONSOLE_OUTPUT);
+    bputs(CAT_HELP, bstdout);
+    bputs(CAT_USE, bstdout);
 
-    Write(MKDIR_HELP,   sizeof(MKDIR_HELP)   - 1, CONSOLE_OUTPUT);
-    Write(MKDIR_USE,   sizeof(MKDIR_USE)   - 1, CONSOLE_OUTPUT);
+    bputs(MKDIR_HELP, bstdout);
+    bputs(MKDIR_USE, bstdout);
 
-    Write(RM_HELP,      sizeof(RM_HELP)      - 1, CONSOLE_OUTPUT);
-    Write(RM_USE,      sizeof(RM_USE)      - 1, CONSOLE_OUTPUT);
-    Write(RMDIR_HELP,   sizeof(RMDIR_HELP)   - 1, CONSOLE_OUTPUT);
-    Write(RMDIR_USE,   sizeof(RMDIR_USE)   - 1, CONSOLE_OUTPUT);
+    bputs(RM_HELP, bstdout);
+    bputs(RM_USE, bstdout);
+    bputs(RMDIR_HELP, bstdout);
+    bputs(RMDIR_USE, bstdout);
 
-    Write(ECHO_HELP,    sizeof(ECHO_HELP)    - 1, CONSOLE_OUTPUT);
+    bputs(ECHO_HELP, bstdout);
 
-    Write(FSTEST_HELP,    sizeof(FSTEST_HELP)    - 1, CONSOLE_OUTPUT);
+    bputs(FSTEST_HELP, bstdout);
 
-    Write(SORT_HELP,    sizeof(SORT_HELP)    - 1, CONSOLE_OUTPUT);
-    Write(MATMULT_HELP, sizeof(MATMULT_HELP) - 1, CONSOLE_OUTPUT);
+    bputs(SORT_HELP, bstdout);
+    bputs(MATMULT_HELP, bstdout);
 
-    Write(HALT_HELP,    sizeof(HALT_HELP)    - 1, CONSOLE_OUTPUT);
-    Write(EXIT_HELP,    sizeof(EXIT_HELP)    - 1, CONSOLE_OUTPUT);
+    bputs(HALT_HELP, bstdout);
+    bputs(EXIT_HELP, bstdout);
 
     return 0;
 }
\ No newline at end of file
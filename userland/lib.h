@@ -15,12 +15,6 @@ char strcmpp(const char *s1, const char *s2) {
     return s1[iter] == '\0' && s2[iter] == '\0' ? 1 : 0;
 }
 
-void putss(const char *s) {
-    Write(s, strlen(s), CONSOLE_OUTPUT);
-    Write("\n", 1, CONSOLE_OUTPUT);
-    return;
-}
-
 void itoa(int n, char* c) {
     if (n == 0) {
         c[0] = 48;
@@ -43,3 +37,346 @@ void itoa(int n, char* c) {
     c[i] = '\0';
     return;
 }
+
+// Heap allocator on top of `Sbrk`, after the one in K&R: free blocks are
+// kept in a circular list sorted by address, and merged with their
+// neighbours when freed.
+
+typedef struct _blockHeader {
+    struct _blockHeader *next;  // next free block
+    unsigned units;             // size of the block, header included
+} BlockHeader;
+
+#define MALLOC_MIN_UNITS 128    // ask the kernel for at least this much
+
+static BlockHeader heapBase;
+static BlockHeader *freeBlocks = 0;
+
+void free(void *p) {
+    if(p == 0)
+        return;
+
+    BlockHeader *block = (BlockHeader *) p - 1;
+    BlockHeader *prev = freeBlocks;
+    while(!(block > prev && block < prev->next)) {
+        // At the end of the list, the block may go past either end.
+        if(prev >= prev->next && (block > prev || block < prev->next))
+            break;
+        prev = prev->next;
+    }
+
+    if(block + block->units == prev->next) {
+        block->units += prev->next->units;
+        block->next = prev->next->next;
+    } else
+        block->next = prev->next;
+
+    if(prev + prev->units == block) {
+        prev->units += block->units;
+        prev->next = block->next;
+    } else
+        prev->next = block;
+
+    freeBlocks = prev;
+}
+
+static BlockHeader *moreHeap(unsigned units) {
+    if(units < MALLOC_MIN_UNITS)
+        units = MALLOC_MIN_UNITS;
+
+    char *p = Sbrk(units * sizeof (BlockHeader));
+    if(p == (char *) -1)
+        return 0;
+
+    BlockHeader *block = (BlockHeader *) p;
+    block->units = units;
+    free(block + 1);
+    return freeBlocks;
+}
+
+void *malloc(unsigned size) {
+    unsigned units = (size + sizeof (BlockHeader) - 1) / sizeof (BlockHeader) + 1;
+
+    if(freeBlocks == 0) {
+        heapBase.next = freeBlocks = &heapBase;
+        heapBase.units = 0;
+    }
+
+    BlockHeader *prev = freeBlocks;
+    for(BlockHeader *block = prev->next; ; prev = block, block = block->next) {
+        if(block->units >= units) {
+            if(block->units == units)
+                prev->next = block->next;
+            else {
+                // Hand out the tail of the block.
+                block->units -= units;
+                block += block->units;
+                block->units = units;
+            }
+            freeBlocks = prev;
+            return block + 1;
+        }
+        if(block == freeBlocks && (block = moreHeap(units)) == 0)
+            return 0;
+    }
+}
+
+// Buffered I/O on top of `Read` and `Write`, after stdio: a stream keeps a
+// buffer, so that reading or writing a few bytes at a time costs a system
+// call per buffer instead of one per call.  Output is written when the
+// buffer fills, on `bflush` and `bclose`, before reading the console, and
+// when `main` returns (see `start.s`) or the program calls `bexit`.
+
+#define BFILE_BUFFER_SIZE 256   // buffer size of the console streams, and of
+                                // the others unless told otherwise
+#define BFILE_MAX         8     // streams open at once, besides the console
+
+typedef struct {
+    OpenFileId id;
+    int writing;    // output stream, or input stream
+    char *buffer;
+    int size;       // capacity of `buffer`
+    int count;      // bytes in `buffer`, to write or read
+    int position;   // next byte of `buffer` to read
+} BFILE;
+
+static char bstdinBuffer[BFILE_BUFFER_SIZE];
+static char bstdoutBuffer[BFILE_BUFFER_SIZE];
+
+BFILE bstdinStream  = { CONSOLE_INPUT,  0, bstdinBuffer,  BFILE_BUFFER_SIZE, 0, 0 };
+BFILE bstdoutStream = { CONSOLE_OUTPUT, 1, bstdoutBuffer, BFILE_BUFFER_SIZE, 0, 0 };
+
+#define bstdin  (&bstdinStream)
+#define bstdout (&bstdoutStream)
+
+static BFILE *openStreams[BFILE_MAX];   // the ones from `bdopen`
+
+// Write out what `f` holds.  Return 0, or -1 in case of error.
+int bflush(BFILE *f) {
+    if(f == 0 || !f->writing)
+        return -1;
+
+    int done = 0;
+    while(done < f->count) {
+        int n = Write(f->buffer + done, f->count - done, f->id);
+        if(n <= 0)
+            break;
+        done += n;
+    }
+    int result = done == f->count ? 0 : -1;
+    f->count = 0;
+    return result;
+}
+
+// Flush every output stream.
+void bflushall(void) {
+    bflush(bstdout);
+    for(unsigned i = 0; i < BFILE_MAX; i++) {
+        if(openStreams[i] != 0 && openStreams[i]->writing)
+            bflush(openStreams[i]);
+    }
+}
+
+// Flush every output stream, and end the program.
+void bexit(int status) {
+    bflushall();
+    Exit(status);
+}
+
+// Return a stream over `id`, already open, for writing or for reading, with
+// a buffer of `size` bytes (`BFILE_BUFFER_SIZE` if 0), or 0 in case of error.
+BFILE *bdopen(OpenFileId id, int writing, int size) {
+    if(size <= 0)
+        size = BFILE_BUFFER_SIZE;
+
+    unsigned slot = 0;
+    while(slot < BFILE_MAX && openStreams[slot] != 0)
+        slot++;
+    if(slot == BFILE_MAX)
+        return 0;
+
+    BFILE *f = malloc(sizeof *f);
+    char *buffer = malloc(size);
+    if(f == 0 || buffer == 0) {
+        free(f);
+        free(buffer);
+        return 0;
+    }
+    f->id = id;
+    f->writing = writing;
+    f->buffer = buffer;
+    f->size = size;
+    f->count = 0;
+    f->position = 0;
+    openStreams[slot] = f;
+    return f;
+}
+
+// Open the file `name`, which must exist, and return a stream over it, as
+// `bdopen` does, or 0 in case of error.
+BFILE *bopen(const char *name, int writing, int size) {
+    OpenFileId id = Open(name);
+    if(id < 0)
+        return 0;
+
+    BFILE *f = bdopen(id, writing, size);
+    if(f == 0)
+        Close(id);
+    return f;
+}
+
+// Flush and close `f`, along with its file unless it is the console.
+// Return 0, or -1 in case of error.
+int bclose(BFILE *f) {
+    if(f == 0)
+        return -1;
+    int result = f->writing ? bflush(f) : 0;
+    if(f == bstdin || f == bstdout)
+        return result;
+
+    if(f->id != CONSOLE_INPUT && f->id != CONSOLE_OUTPUT)
+        Close(f->id);
+    for(unsigned i = 0; i < BFILE_MAX; i++) {
+        if(openStreams[i] == f)
+            openStreams[i] = 0;
+    }
+    free(f->buffer);
+    free(f);
+    return result;
+}
+
+// Refill the buffer of the input stream `f`, and return how many bytes it
+// got, 0 at the end of the file.
+static int bfill(BFILE *f) {
+    // Whatever the program asked for input with must show first.
+    if(f->id == CONSOLE_INPUT)
+        bflush(bstdout);
+
+    int n = Read(f->buffer, f->size, f->id);
+    f->position = 0;
+    f->count = n > 0 ? n : 0;
+    return f->count;
+}
+
+// Read `size` bytes from `f` into `buffer`, fewer only at the end of the
+// file.  Return how many, or -1 in case of error.
+int bread(BFILE *f, char *buffer, int size) {
+    if(f == 0 || f->writing || buffer == 0 || size < 0)
+        return -1;
+
+    int done = 0;
+    while(done < size) {
+        if(f->position == f->count) {
+            // What is left fills the buffer anyway: skip it.
+            if(size - done >= f->size) {
+                int n = Read(buffer + done, size - done, f->id);
+                if(n <= 0)
+                    break;
+                done += n;
+                continue;
+            }
+            if(bfill(f) == 0)
+                break;
+        }
+        while(done < size && f->position < f->count)
+            buffer[done++] = f->buffer[f->position++];
+    }
+    return done;
+}
+
+// Write the `size` bytes of `buffer` to `f`.  Return `size`, or -1 in case
+// of error.
+int bwrite(BFILE *f, const char *buffer, int size) {
+    if(f == 0 || !f->writing || buffer == 0 || size < 0)
+        return -1;
+
+    if(f->count + size > f->size && bflush(f) < 0)
+        return -1;
+    // Too much for the buffer: write it right away.
+    if(size >= f->size)
+        return Write(buffer, size, f->id) == size ? size : -1;
+
+    for(int i = 0; i < size; i++)
+        f->buffer[f->count++] = buffer[i];
+    return size;
+}
+
+// Return the next byte of `f`, or -1 at the end of the file.
+int bgetc(BFILE *f) {
+    if(f == 0 || f->writing)
+        return -1;
+    if(f->position == f->count && bfill(f) == 0)
+        return -1;
+    return (unsigned char) f->buffer[f->position++];
+}
+
+int bputc(char c, BFILE *f) {
+    return bwrite(f, &c, 1) == 1 ? (unsigned char) c : -1;
+}
+
+int bputs(const char *s, BFILE *f) {
+    return bwrite(f, s, strlen(s));
+}
+
+// Read a line of `f` into `line`, newline included, up to `size - 1` bytes,
+// and end it with a null character.  Return `line`, or 0 if the file was
+// over.
+char *bgets(char *line, int size, BFILE *f) {
+    if(line == 0 || size <= 0)
+        return 0;
+
+    int i = 0;
+    while(i < size - 1) {
+        int c = bgetc(f);
+        if(c == -1)
+            break;
+        line[i++] = c;
+        if(c == '\n')
+            break;
+    }
+    line[i] = '\0';
+    return i > 0 ? line : 0;
+}
+
+// Locks for the threads of a process (see `ThreadCreate`), after the ones
+// in "Futexes Are Tricky": a lock is a word that holds 0 when it is free, 1
+// when it is taken, and 2 when it is taken and threads may be sleeping on
+// it, so that releasing it only enters the kernel when needed.  Lock words
+// must start as 0.
+
+// Store `value` in `*word` and return what it held, at once with respect to
+// the other threads, with the `LL` and `SC` instructions of MIPS II.
+int swapword(int *word, int value) {
+    int old, stored;
+    do {
+        __asm__ volatile(".set push\n\t"
+                         ".set mips2\n\t"
+                         "ll   %0, 0(%2)\n\t"
+                         "move %1, %3\n\t"
+                         "sc   %1, 0(%2)\n\t"
+                         ".set pop"
+                         : "=&r" (old), "=&r" (stored)
+                         : "r" (word), "r" (value)
+                         : "memory");
+    } while(!stored);
+    return old;
+}
+
+void acquire(int *lock) {
+    if(swapword(lock, 1) == 0)
+        return;
+    // Whoever gets the lock from here on leaves it marked as contended.
+    while(swapword(lock, 2) != 0)
+        FutexWait(lock, 2);
+}
+
+void release(int *lock) {
+    if(swapword(lock, 0) == 2)
+        FutexWake(lock, 1);
+}
+
+void putss(const char *s) {
+    bputs(s, bstdout);
+    bputc('\n', bstdout);
+    return;
+}
@@ -7,20 +7,24 @@
 
 
 #include "syscall.h"
+#include "lib.h"
 
 
 /// Sum total of the arrays does not fit in physical memory.
 #define DIM  20
 
-static int A[DIM][DIM];
-static int B[DIM][DIM];
-static int C[DIM][DIM];
-
 int
 main(void)
 {
     int i, j, k;
 
+    int (*A)[DIM] = malloc(DIM * sizeof *A);
+    int (*B)[DIM] = malloc(DIM * sizeof *B);
+    int (*C)[DIM] = malloc(DIM * sizeof *C);
+    if (A == 0 || B == 0 || C == 0) {
+        return -1;
+    }
+
     // First initialize the matrices.
     for (i = 0; i < DIM; i++) {
         for (j = 0; j < DIM; j++) {
@@ -2,52 +2,40 @@
 
 #define MAX_LINE_SIZE  300
 #define MAX_ARG_COUNT  32
+#define MAX_STAGES     8
 #define ARG_SEPARATOR  ' '
+#define PIPE_SEPARATOR '|'
 
 #define NULL ((void *) 0)
 
 static inline void
-WritePrompt(OpenFileId output)
+WritePrompt(BFILE *output)
 {
-    static const char PROMPT[] = "--> ";
-    Write(PROMPT, sizeof PROMPT - 1, output);
+    bputs("--> ", output);
     return;
 }
 
 static inline void
-WriteError(const char *description, OpenFileId output)
+WriteError(const char *description, BFILE *output)
 {
-    static const char PREFIX[] = "Error: ";
-    static const char SUFFIX[] = "\n";
-    unsigned len = strlen(description);
-
-    Write(PREFIX, sizeof PREFIX - 1, output);
-
-    !len ? Write("bad description", sizeof("bad description"), output)
-         : Write(description, len, output);
-
-    Write(SUFFIX, sizeof SUFFIX - 1, output);
+    bputs("Error: ", output);
+    bputs(strlen(description) ? description : "bad description", output);
+    bputc('\n', output);
 
     return;
 }
 
 static unsigned
-ReadLine(char *buffer, unsigned size, OpenFileId input)
+ReadLine(char *buffer, unsigned size, BFILE *input)
 {
-    if(buffer == NULL)
+    if(buffer == NULL || bgets(buffer, size, input) == NULL)
         return 0;
 
-    unsigned i;
-
-    for (i = 0; i < size; i++) {
-        Read(&buffer[i], 1, input);
-        if (buffer[i] == '\n') {
-            buffer[i] = '\0';
-            break;
-        }
-    }
+    unsigned n = strlen(buffer);
+    if (buffer[n - 1] == '\n')
+        buffer[--n] = '\0';
 
-    return i;
+    return n;
 }
 
 static int
@@ -83,85 +71,167 @@ PrepareArguments(char *line, char **argv, unsigned argvSize)
     return 0;
 }
 
+/// Split `line` at every `PIPE_SEPARATOR`, and store where each command
+/// starts in `stages`, without the spaces around it.  Return how many there
+/// are, or 0 if one of them is empty or there are too many.
+static unsigned
+SplitPipeline(char *line, char **stages, unsigned maxStages)
+{
+    unsigned count = 0;
+
+    for (char *stage = line; ; ) {
+        while(*stage == ARG_SEPARATOR)
+            stage++;
+        if(*stage == '\0' || *stage == PIPE_SEPARATOR || count == maxStages)
+            return 0;
+        stages[count++] = stage;
+
+        char *end = stage;
+        while(*end != '\0' && *end != PIPE_SEPARATOR)
+            end++;
+        const int last = *end == '\0';
+        *end = '\0';
+        for (char *t = end; t > stage && t[-1] == ARG_SEPARATOR; )
+            *--t = '\0';
+        if(last)
+            return count;
+        stage = end + 1;
+    }
+}
 
-SpaceId ExecuteAlias(char* line, char** argv, int joinable) {
+SpaceId ExecuteAlias(char* line, char** argv, int joinable, const OpenFileId *streams) {
 
-    SpaceId result = 0;
+    char *path = line;
 
     if(argv[0] == NULL)
         argv = NULL;
 
     /// Utils
     if(strcmpp(line, "echo"))
-        result = Exec("userland/echo", argv, joinable);
+        path = "userland/echo";
 
     else if(strcmpp(line, "exit"))
-        result = Exec("userland/halt", argv, joinable);
+        path = "userland/halt";
 
     else if(strcmpp(line, "halt"))
-        result = Exec("userland/halt", argv, joinable);
+        path = "userland/halt";
 
     else if(strcmpp(line, "sort"))
-        result = Exec("userland/sort", argv, joinable);
+        path = "userland/sort";
 
     else if(strcmpp(line, "cat"))
-        result = Exec("userland/cat", argv, joinable);
+        path = "userland/cat";
 
     else if(strcmpp(line, "cat>"))
-        result = Exec("userland/write", argv, joinable);
+        path = "userland/write";
 
     else if(strcmpp(line, "write"))
-        result = Exec("userland/write", argv, joinable);
+        path = "userland/write";
 
     else if(strcmpp(line, "matmult"))
-        result = Exec("userland/matmult", argv, joinable);
+        path = "userland/matmult";
 
     else if(strcmpp(line, "help"))
-        result = Exec("userland/help", argv, joinable);
+        path = "userland/help";
 
     else if(strcmpp(line, "filetest"))
-        result = Exec("userland/filetest", argv, joinable);
+        path = "userland/filetest";
 
 
     // Filesystem realated
     else if(strcmpp(line, "touch"))
-        result = Exec("userland/touch", argv, joinable);
+        path = "userland/touch";
 
     else if(strcmpp(line, "create"))
-        result = Exec("userland/touch", argv, joinable);
+        path = "userland/touch";
 
     else if(strcmpp(line, "rm"))
-        result = Exec("userland/rm", argv, joinable);
+        path = "userland/rm";
 
     else if(strcmpp(line, "cp"))
-        result = Exec("userland/cp", argv, joinable);
+        path = "userland/cp";
 
     else if(strcmpp(line, "ls"))
-        result = Exec("userland/ls", argv, joinable);
+        path = "userland/ls";
 
     else if(strcmpp(line, "cd"))
-        result = Exec("userland/cd", argv, joinable);
+        path = "userland/cd";
 
     else if(strcmpp(line, "mkdir"))
-        result = Exec("userland/mkdir", argv, joinable);
+        path = "userland/mkdir";
 
     else if(strcmpp(line, "rmdir"))
-        result = Exec("userland/rmdir", argv, joinable);
+        path = "userland/rmdir";
 
+    return ExecRedirect(path, argv, joinable, streams);
+}
 
-    else
-        result = Exec(line, argv, joinable);
+/// Run the commands of `stages`, each one writing to the next through a
+/// pipe, all at the same time.  Wait for them unless `background`.
+static void
+RunPipeline(char **stages, unsigned numStages, int background,
+            BFILE *output)
+{
+    char        *argv[MAX_STAGES][MAX_ARG_COUNT];
+    SpaceId     procs[MAX_STAGES];
+    OpenFileId  input = CONSOLE_INPUT;
+    unsigned    started;
+
+    for (unsigned i = 0; i < numStages; i++) {
+        if(PrepareArguments(stages[i], argv[i], MAX_ARG_COUNT)) {
+            WriteError("bad arguments.", output);
+            return;
+        }
+    }
+
+    for (started = 0; started < numStages; started++) {
+        OpenFileId ends[2];
+        OpenFileId streams[2] = { input, CONSOLE_OUTPUT };
+        int last = started == numStages - 1;
+
+        if(!last) {
+            if(Pipe(ends) < 0) {
+                WriteError("could not create a pipe.", output);
+                break;
+            }
+            streams[1] = ends[1];
+        }
 
-    return result;
+        procs[started] = ExecuteAlias(stages[started], argv[started],
+                                      !background, streams);
+
+        // The children have their own ends now.
+        if(input != CONSOLE_INPUT)
+            Close(input);
+        input = CONSOLE_INPUT;
+        if(!last) {
+            Close(ends[1]);
+            input = ends[0];
+        }
+
+        if(procs[started] < 0) {
+            WriteError("error forking child", output);
+            break;
+        }
+    }
+    if(input != CONSOLE_INPUT)
+        Close(input);
+
+    // Errors show before whatever the children write.
+    bflush(output);
+
+    if(!background) {
+        for (unsigned i = 0; i < started; i++)
+            Join(procs[i]);
+    }
 }
 
 int
 main(void)
 {
-    const OpenFileId      INPUT = CONSOLE_INPUT;
-    const OpenFileId      OUTPUT = CONSOLE_OUTPUT;
+    BFILE * const         INPUT = bstdin;
+    BFILE * const         OUTPUT = bstdout;
     char                  line[MAX_LINE_SIZE];
-    char                  *argv[MAX_ARG_COUNT];
 
     for (;;) {
         WritePrompt(OUTPUT);
@@ -172,34 +242,20 @@ main(void)
             continue;
         }
 
-        const int args = PrepareArguments(line, argv, MAX_ARG_COUNT);
-        if(args) {
-            WriteError("bad arguments.", OUTPUT);
+        //convention: &command args | command args ...
+        //Excecute the given programs with the argvs, each one reading
+        //what the previous one writes
+
+        int background = line[0] == '&'; //Execute in the background
+        char *stages[MAX_STAGES];
+        const unsigned numStages = SplitPipeline(background ? &line[1] : line,
+                                                 stages, MAX_STAGES);
+        if(numStages == 0) {
+            WriteError("bad pipeline.", OUTPUT);
             continue;
         }
 
-        //convention: &command args
-        //Excecute a given program with the argvs
-
-        if(line[0] == '&') { //Execute in the background
-
-            const SpaceId newProc = ExecuteAlias(&line[1], argv, 0);
-
-            if(newProc < 0) {
-                WriteError("error forking child", OUTPUT);
-                continue;
-            }
-        } else { //Execute with join
-
-            const SpaceId newProc = ExecuteAlias(line, argv, 1);
-
-            if(newProc < 0) {
-                WriteError("error forking child", OUTPUT);
-                continue;
-            } else {
-                Join(newProc);
-            }
-        }
+        RunPipeline(stages, numStages, background, OUTPUT);
     }
 
     // Never reached.
@@ -11,9 +11,6 @@
 
 #define DIM  1024
 
-/// Size of physical memory; with code, we will run out of space!
-static int A[DIM];
-
 int
 main(void)
 {
@@ -21,6 +18,13 @@ main(void)
 
     char c[8];
 
+    // Size of physical memory; with code, we will run out of space!
+    int *A = malloc(DIM * sizeof *A);
+    if (A == 0) {
+        putss("Not enough memory.");
+        return -1;
+    }
+
     // First initialize the array, in reverse sorted order.
     for (i = 0; i < DIM; i++) {
         A[i] = DIM - i;
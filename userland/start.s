@@ -20,12 +20,19 @@
         .ent    __start
 __start:
         jal     main
-        // If `main` returns, invoke `Exit` with the return value as
+        // If `main` returns, flush the buffered output of `lib.h`, if the
+        // program has any, and invoke `Exit` with the return value as
         // argument.
-        move    $4, $2
+        move    $16, $2
+        la      $8, bflushall
+        beq     $8, $0, 1f
+        jalr    $8
+1:      move    $4, $16
         jal     Exit
         .end    __start
 
+        .weak   bflushall
+
 /// System call stubs
 ///
 /// Assembly language assist to make system calls to the Nachos kernel.
@@ -85,6 +92,43 @@ Yield:
         j       $31
         .end    Yield
 
+        .globl  ThreadCreate
+        .ent    ThreadCreate
+ThreadCreate:
+        // The new thread starts at `__thread_start`, given in `$7`, with
+        // the function in `$4` and its argument in `$5`.
+        la      $7, __thread_start
+        addiu   $2, $0, SC_THREADCREATE
+        syscall
+        j       $31
+        .end    ThreadCreate
+
+/// Run the function of a new thread, and invoke `Exit` with its result.
+        .ent    __thread_start
+__thread_start:
+        move    $8, $4
+        move    $4, $5
+        jalr    $8
+        move    $4, $2
+        jal     Exit
+        .end    __thread_start
+
+        .globl  FutexWait
+        .ent    FutexWait
+FutexWait:
+        addiu   $2, $0, SC_FUTEXWAIT
+        syscall
+        j       $31
+        .end    FutexWait
+
+        .globl  FutexWake
+        .ent    FutexWake
+FutexWake:
+        addiu   $2, $0, SC_FUTEXWAKE
+        syscall
+        j       $31
+        .end    FutexWake
+
         .globl  Create
         .ent    Create
 Create:
@@ -132,6 +176,150 @@ Close:
         syscall
         j       $31
         .end    Close
+
+        .globl  Mmap
+        .ent    Mmap
+Mmap:
+        addiu   $2, $0, SC_MMAP
+        syscall
+        j       $31
+        .end    Mmap
+
+        .globl  Munmap
+        .ent    Munmap
+Munmap:
+        addiu   $2, $0, SC_MUNMAP
+        syscall
+        j       $31
+        .end    Munmap
+
+        .globl  ShmCreate
+        .ent    ShmCreate
+ShmCreate:
+        addiu   $2, $0, SC_SHMCREATE
+        syscall
+        j       $31
+        .end    ShmCreate
+
+        .globl  ShmAttach
+        .ent    ShmAttach
+ShmAttach:
+        addiu   $2, $0, SC_SHMATTACH
+        syscall
+        j       $31
+        .end    ShmAttach
+
+        .globl  ShmDetach
+        .ent    ShmDetach
+ShmDetach:
+        addiu   $2, $0, SC_SHMDETACH
+        syscall
+        j       $31
+        .end    ShmDetach
+
+        .globl  Sbrk
+        .ent    Sbrk
+Sbrk:
+        addiu   $2, $0, SC_SBRK
+        syscall
+        j       $31
+        .end    Sbrk
+
+        .globl  Seek
+        .ent    Seek
+Seek:
+        addiu   $2, $0, SC_SEEK
+        syscall
+        j       $31
+        .end    Seek
+
+        .globl  PRead
+        .ent    PRead
+PRead:
+        addiu   $2, $0, SC_PREAD
+        syscall
+        j       $31
+        .end    PRead
+
+        .globl  PWrite
+        .ent    PWrite
+PWrite:
+        addiu   $2, $0, SC_PWRITE
+        syscall
+        j       $31
+        .end    PWrite
+
+        .globl  ReadV
+        .ent    ReadV
+ReadV:
+        addiu   $2, $0, SC_READV
+        syscall
+        j       $31
+        .end    ReadV
+
+        .globl  WriteV
+        .ent    WriteV
+WriteV:
+        addiu   $2, $0, SC_WRITEV
+        syscall
+        j       $31
+        .end    WriteV
+
+        .globl  CopyFile
+        .ent    CopyFile
+CopyFile:
+        addiu   $2, $0, SC_COPYFILE
+        syscall
+        j       $31
+        .end    CopyFile
+
+        .globl  IoSetup
+        .ent    IoSetup
+IoSetup:
+        addiu   $2, $0, SC_IOSETUP
+        syscall
+        j       $31
+        .end    IoSetup
+
+        .globl  IoEnter
+        .ent    IoEnter
+IoEnter:
+        addiu   $2, $0, SC_IOENTER
+        syscall
+        j       $31
+        .end    IoEnter
+
+        .globl  ExecRedirect
+        .ent    ExecRedirect
+ExecRedirect:
+        addiu   $2, $0, SC_EXECREDIRECT
+        syscall
+        j       $31
+        .end    ExecRedirect
+
+        .globl  Pipe
+        .ent    Pipe
+Pipe:
+        addiu   $2, $0, SC_PIPE
+        syscall
+        j       $31
+        .end    Pipe
+
+        .globl  MsgSend
+        .ent    MsgSend
+MsgSend:
+        addiu   $2, $0, SC_MSGSEND
+        syscall
+        j       $31
+        .end    MsgSend
+
+        .globl  MsgRecv
+        .ent    MsgRecv
+MsgRecv:
+        addiu   $2, $0, SC_MSGRECV
+        syscall
+        j       $31
+        .end    MsgRecv
 Ls:
         addiu   $2, $0, SC_LSDIR
         syscall
@@ -1,4 +1,5 @@
 #include "syscall.h"
+#include "lib.h"
 
 #define NULL ((void *) 0)
 
@@ -6,27 +7,29 @@ int
 main(void)
 {
     SpaceId    newProc;
-    OpenFileId input  = CONSOLE_INPUT;
-    OpenFileId output = CONSOLE_OUTPUT;
+    BFILE      *input  = bstdin;
+    BFILE      *output = bstdout;
     char       prompt[2] = { '-', '-' };
-    char       ch, buffer[60];
+    char       buffer[60];
     int        i;
 
     for (;;) {
-        Write(prompt, 2, output);
-        i = 0;
-        do {
-            Read(&buffer[i], 1, input);
-        } while (buffer[i++] != '\n');
+        bwrite(output, prompt, 2);
+        if (bgets(buffer, sizeof buffer, input) == NULL) {
+            break;
+        }
 
-        buffer[--i] = '\0';
+        i = strlen(buffer);
+        if (i > 0 && buffer[i - 1] == '\n') {
+            buffer[--i] = '\0';
+        }
 
         if (i > 0) {
             newProc = Exec(buffer, NULL, 1);
             if(newProc > 0) {
                 Join(newProc);
             } else {
-                Write("Error: forking child.\n", sizeof("Error: forking child.\n") - 1, output);
+                bputs("Error: forking child.\n", output);
             }
         }
     }
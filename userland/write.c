@@ -6,16 +6,15 @@
 #define CREATE_ERROR "Error: could not create file.\n"
 
 int
-PrintString(const char *s, OpenFileId fileToWrite)
+PrintString(const char *s, BFILE *fileToWrite)
 {
-    unsigned len = strlen(s);
-    return Write(s, len, fileToWrite);
+    return bputs(s, fileToWrite);
 }
 
 int
-PrintChar(char c, OpenFileId fileToWrite)
+PrintChar(char c, BFILE *fileToWrite)
 {
-    return Write(&c, 1, fileToWrite);
+    return bputc(c, fileToWrite);
 }
 
 int
@@ -26,17 +25,17 @@ main(int argc, char *argv[])
         Exit(1);
     }
 
-    OpenFileId fileToWrite = Open(argv[0]);
+    BFILE *fileToWrite = bopen(argv[0], 1, 0);
 
-    if(fileToWrite < 0) {
+    if(fileToWrite == 0) {
         int notSuccess = Create(argv[0], 0);
         if(notSuccess) {
             Write(CREATE_ERROR, sizeof(CREATE_ERROR) - 1, CONSOLE_OUTPUT);
             Exit(1);
         }
 
-        fileToWrite = Open(argv[0]);
-        if(fileToWrite < 0) {
+        fileToWrite = bopen(argv[0], 1, 0);
+        if(fileToWrite == 0) {
             Write(OPEN_ERROR, sizeof(OPEN_ERROR) - 1, CONSOLE_OUTPUT);
             Exit(1);
         }
@@ -53,5 +52,5 @@ main(int argc, char *argv[])
 
     PrintChar('\n', fileToWrite);
 
-    Close(fileToWrite);
+    bclose(fileToWrite);
 }
\ No newline at end of file
@@ -14,6 +14,65 @@
 #include <stdio.h>
 
 
+/// Return how many of the `size` bytes at virtual address `start` hold code
+/// or initialized data, as found in `exe`.
+static uint32_t
+CoveredBytes(Executable *exe, uint32_t start, uint32_t size)
+{
+    uint32_t end = start + size;
+
+    uint32_t codeFrom = start > exe->GetCodeAddr() ? start : exe->GetCodeAddr();
+    uint32_t codeTo   = end < exe->GetCodeAddr() + exe->GetCodeSize()
+                        ? end : exe->GetCodeAddr() + exe->GetCodeSize();
+    uint32_t dataFrom = start > exe->GetInitDataAddr() ? start : exe->GetInitDataAddr();
+    uint32_t dataTo   = end < exe->GetInitDataAddr() + exe->GetInitDataSize()
+                        ? end : exe->GetInitDataAddr() + exe->GetInitDataSize();
+
+    return (codeFrom < codeTo ? codeTo - codeFrom : 0)
+         + (dataFrom < dataTo ? dataTo - dataFrom : 0);
+}
+
+/// Fill `size` bytes at `into` with the initial content of the virtual
+/// addresses starting at `start`.  The parts of the code and initialized data
+/// segments in that range are read from `exe` with one read each; the rest
+/// (uninitialized data and stack) is zero-filled without any I/O, unless
+/// `zeroed` tells that `into` is all zero already.
+static void
+ReadSegments(Executable *exe, uint32_t start, uint32_t size, char *into, bool zeroed)
+{
+    uint32_t end = start + size;
+
+    uint32_t codeFrom = start > exe->GetCodeAddr() ? start : exe->GetCodeAddr();
+    uint32_t codeTo   = end < exe->GetCodeAddr() + exe->GetCodeSize()
+                        ? end : exe->GetCodeAddr() + exe->GetCodeSize();
+    uint32_t dataFrom = start > exe->GetInitDataAddr() ? start : exe->GetInitDataAddr();
+    uint32_t dataTo   = end < exe->GetInitDataAddr() + exe->GetInitDataSize()
+                        ? end : exe->GetInitDataAddr() + exe->GetInitDataSize();
+
+    if (CoveredBytes(exe, start, size) < size) {
+        if (zeroed)
+            stats->numZeroFillsSkipped++;
+        else
+            memset(into, 0, size);
+    }
+
+    if (codeFrom < codeTo) {
+        DEBUG('a', "Reading %u bytes of code...\n", codeTo - codeFrom);
+        exe->ReadCodeBlock(&into[codeFrom - start], codeTo - codeFrom, codeFrom - exe->GetCodeAddr());
+    }
+    if (dataFrom < dataTo) {
+        DEBUG('a', "Reading %u bytes of data...\n", dataTo - dataFrom);
+        exe->ReadDataBlock(&into[dataFrom - start], dataTo - dataFrom, dataFrom - exe->GetInitDataAddr());
+    }
+}
+
+#ifdef SWAP
+/// Live address spaces, indexed by their `SpaceId`.  After a `Fork`, a
+/// physical page may be mapped by several of them, always at the same
+/// virtual page.
+static AddressSpace *liveSpaces[Table<Thread *>::SIZE];
+#endif
+
 /// First, set up the translation from program memory to physical memory.
 /// For now, this is really simple (1:1), since we are only uniprogramming,
 /// and we have a single unsegmented page table.
@@ -23,247 +82,1143 @@ AddressSpace::AddressSpace(OpenFile *executable_file, SpaceId spaceId)
 
 #ifdef DEMAND_LOADING
     exeFile = executable_file;
+    exeFileUsers = new unsigned(1);
     #ifdef SWAP
-        char* swapFile = new char[30];
-        sprintf(swapFile, "userprog/SWAP/SWAP.%d", spaceId);
-        #ifdef FILESYS
-        if(!fileSystem->Create(swapFile, 0, true)) {
-        #else
-        if(!fileSystem->Create(swapFile, 0)) {
-        #endif
-            DEBUG('a', "Error: Swap file not created.\n");
-        }
-
-        // We can have the approach of open the file every time we write in swap, but for testing we are forcing the OS to have
-        // very poor number of physical pages.
-        #ifdef FILESYS
-        openSwapFile = fileSystem->Open(swapFile, true);
-        #else
-        openSwapFile = fileSystem->Open(swapFile);
-        #endif
-
-        delete [] swapFile;
-        if(openSwapFile == nullptr) {
-            DEBUG('a', "Cannot open SWAP FILE!!!!\n");
-            ASSERT(false);
-        }
-
         addressSpaceId = spaceId;  //to replace the coreMap later
+        liveSpaces[spaceId] = this;
     #endif
 #endif
 
+#ifdef DEMAND_LOADING
+    // Parse the header once, every page fault reads through it.
+    executable = new Executable(executable_file);
+    Executable &exe = *executable;
+#else
     Executable exe (executable_file);
+#endif
     ASSERT(exe.CheckMagic()); //check if the executable is a nachos binary
 
 #ifdef DEMAND_LOADING
     codeSize = exe.GetCodeSize();
     initDataSize = exe.GetInitDataSize();
 
+    codeVirtualAddr = exe.GetCodeAddr();
     dataVirtualAddr = exe.GetInitDataAddr();
 
+    readaheadWindow = 0;
+    nextSequentialVpn = 0;
+
     DEBUG('a',"Loading information: codeAddr: %d initDataAddr: %d, ", exe.GetCodeAddr(), exe.GetInitDataAddr());
 #endif
 
-    // We need to increase the size to leave room for the stack.
-    unsigned size = exe.GetSize() + USER_STACK_SIZE;
+    // The program is followed by room for the heap to grow, a guard page,
+    // and the stack, at the top.
+    imagePages = DivRoundUp(exe.GetSize(), PAGE_SIZE);
+    heapBreak = imagePages * PAGE_SIZE;
+    for (unsigned i = 0; i < MAX_USER_THREADS; i++) {
+        threadStacks[i]    = 0;
+        threadStackUsed[i] = false;
+    }
+
+    numPages = imagePages + MAX_HEAP_PAGES + 1 + MAX_STACK_PAGES;
+    unsigned size = numPages * PAGE_SIZE;
 
-    numPages = DivRoundUp(size, PAGE_SIZE);
-    size = numPages * PAGE_SIZE;
+#ifndef DEMAND_LOADING
+    // Without page faults, the stack cannot grow: it gets its initial size
+    // right away.
+    unsigned stackPages = DivRoundUp(USER_STACK_SIZE, PAGE_SIZE);
+#endif
+
+#ifdef DEMAND_LOADING
+    programPages = numPages;
+    for (unsigned i = 0; i < MAX_MAPPINGS; i++)
+        mappings[i].numPages = 0;
+#endif
 
     DEBUG('a', "clean count: %u, numPages: %u, size: %u\n", addressesBitMap->CountClear(), numPages, size);
 #ifndef SWAP
     // por enunciado tenemos que todos los programas entran en memoria con demand loading
     // Check we are not trying to run anything too big -- at least until we
     // have virtual memory.
-    ASSERT(numPages <= addressesBitMap->CountClear());
+#ifdef DEMAND_LOADING
+    ASSERT(imagePages <= addressesBitMap->CountClear());
+#else
+    ASSERT(imagePages + stackPages <= addressesBitMap->CountClear());
+#endif
 #endif
     DEBUG('a', "Initializing address space, num pages %u, size %u\n",
           numPages, size);
 
     // First, set up the translation.
 
-    pageTable = new TranslationEntry[numPages];
+    // Every page starts out invalid and out of memory; with demand loading,
+    // second-level tables are only allocated when their pages are first
+    // referenced.
+    pageTable.Resize(numPages);
 
-    for (unsigned i = 0; i < numPages; i++) {
-        pageTable[i].virtualPage = i;
 #ifndef DEMAND_LOADING
-        pageTable[i].physicalPage = addressesBitMap->Find();
+    DEBUG('a', "Not using demand loading...\n");
+
+    // Copy in the code and data segments, a page at a time, and zero the
+    // uninitialized data and stack pages.  Pages that are not entirely read
+    // from the executable get a zeroed frame, if there is one.
+    char *mainMemory = machine->GetMMU()->mainMemory;
+    DEBUG('a', "Initializing code segment, at 0x%X, size %u\n", exe.GetCodeAddr(), exe.GetCodeSize());
+    DEBUG('a', "Initializing data segment, at 0x%X, size %u\n", exe.GetInitDataAddr(), exe.GetInitDataSize());
+
+    for (unsigned i = 0; i < numPages; i++) {
+        if (i == imagePages)  // skip the heap and the bottom of the stack
+            i = numPages - stackPages;
+        bool wantZeroed = CoveredBytes(&exe, i * PAGE_SIZE, PAGE_SIZE) < PAGE_SIZE;
+        bool zeroed;
+        pageTable[i].physicalPage = zeroDaemon->TakeFrame(wantZeroed, &zeroed);
         pageTable[i].valid        = true;
-#else
-        pageTable[i].physicalPage = INT_MAX;
-        pageTable[i].valid        = false;
-#endif
-        pageTable[i].use          = false;
-        pageTable[i].dirty        = false;
-        pageTable[i].readOnly     = false;
           // If the code segment was entirely on a separate page, we could
           // set its pages to be read-only.
+        ReadSegments(&exe, i * PAGE_SIZE, PAGE_SIZE, &mainMemory[pageTable[i].physicalPage * PAGE_SIZE], zeroed);
     }
+#else
+  DEBUG('a', "Using demand loading...\n");
+#endif
+}
 
-#ifndef DEMAND_LOADING
-
-    DEBUG('a', "Not using demand loading...\n");
+AddressSpace::AddressSpace(AddressSpace *parent, SpaceId spaceId)
+{
+    ASSERT(parent != nullptr);
 
-    char *mainMemory = machine->GetMMU()->mainMemory;
-    // Zero out the entire address space, to zero the unitialized data
-    // segment and the stack segment.
-    //Cleaning the memory that will be used...
+    numPages = parent->numPages;
+    imagePages = parent->imagePages;
+    heapBreak = parent->heapBreak;
 
-    for(unsigned i = 0; i < numPages; i++) {
-      memset(&mainMemory[pageTable[i].physicalPage * PAGE_SIZE], 0, PAGE_SIZE); //looks fine
+    // The child only has the thread that forked, but the stacks of the
+    // others are in its heap too, free for its own threads.
+    for (unsigned i = 0; i < MAX_USER_THREADS; i++) {
+        threadStacks[i]    = parent->threadStacks[i];
+        threadStackUsed[i] = false;
     }
 
-    // Then, copy in the code and data segments into memory.
-    uint32_t codeSize = exe.GetCodeSize();
-    uint32_t initDataSize = exe.GetInitDataSize();
-
-    if (codeSize > 0) {
-        uint32_t virtualAddr = exe.GetCodeAddr();
+#ifdef DEMAND_LOADING
+    // Mapped files are not inherited, just like open files.
+    numPages = programPages = parent->programPages;
+    for (unsigned i = 0; i < MAX_MAPPINGS; i++)
+        mappings[i].numPages = 0;
+
+    exeFile = parent->exeFile;
+    executable = parent->executable;
+    exeFileUsers = parent->exeFileUsers;
+    (*exeFileUsers)++;
+
+    codeSize = parent->codeSize;
+    initDataSize = parent->initDataSize;
+    codeVirtualAddr = parent->codeVirtualAddr;
+    dataVirtualAddr = parent->dataVirtualAddr;
+
+    readaheadWindow = 0;
+    nextSequentialVpn = 0;
+#endif
 
-        DEBUG('a', "Initializing code segment, at 0x%X, size %u\n", virtualAddr, codeSize);
+#ifdef SWAP
+    addressSpaceId = spaceId;
+    liveSpaces[spaceId] = this;
 
-        for(unsigned i = 0; i < codeSize; i++) {
+    // Bring the bits the TLB holds back into the page table of the parent,
+    // and drop its translations: they are about to become read-only.
+    parent->SaveState();
+#else
+    unsigned residentPages = 0;
+    for (unsigned i = 0; i < numPages; i++) {
+        TranslationEntry *entry = parent->pageTable.Find(i);
+        if(entry != nullptr && entry->physicalPage != INT_MAX)
+            residentPages++;
+    }
+    ASSERT(residentPages <= addressesBitMap->CountClear());
 
-            uint32_t frame  = (uint32_t)((virtualAddr + i) / PAGE_SIZE);  //obtengo el numero de pagina corresp al bit que quiero leer
-            uint32_t offset = (virtualAddr + i) % PAGE_SIZE ; //dentro de esa pagina, me ubico en donde voy a leer
-            uint32_t physicalAddressToWrite = pageTable[frame].physicalPage * PAGE_SIZE + offset;
+    char *mainMemory = machine->GetMMU()->mainMemory;
+#endif
 
-            exe.ReadCodeBlock(&mainMemory[physicalAddressToWrite], 1, i); //leo un byte de la memoria fisica luego de moverme 'i' offset
-        }
-    }
-    if (initDataSize > 0) {
-        uint32_t virtualAddr = exe.GetInitDataAddr();
-        DEBUG('a', "Initializing data segment, at 0x%X, size %u\n", virtualAddr, initDataSize);
+    DEBUG('a', "Forking address space, num pages %u\n", numPages);
 
-        for(unsigned i = 0; i < initDataSize; i++) {
+    // Only the second-level tables the parent has are copied.
+    pageTable.Resize(numPages);
 
-            uint32_t frame  = (uint32_t)((virtualAddr + i) / PAGE_SIZE);
-            uint32_t offset = (virtualAddr + i) % PAGE_SIZE ;
-            uint32_t physicalAddressToWrite = pageTable[frame].physicalPage * PAGE_SIZE + offset;
+    for (unsigned i = 0; i < numPages; i++) {
+        TranslationEntry *parentEntry = parent->pageTable.Find(i);
+        if(parentEntry == nullptr)
+            continue;
+        pageTable[i] = *parentEntry;
+        pageTable[i].use = false;
 
-            exe.ReadDataBlock(&mainMemory[physicalAddressToWrite], 1, i);
+#ifdef SWAP
+        pageTable.SwapSlot(i) = parent->pageTable.SwapSlot(i);
+        if(pageTable.SwapSlot(i) != -1)
+            swapArea->ShareSlot(pageTable.SwapSlot(i));
+
+        if(pageTable[i].physicalPage != INT_MAX) {
+            coreMap[pageTable[i].physicalPage]->refCount++;
+            parentEntry->readOnly = true;
+            pageTable[i].readOnly = true;
         }
-    }
 #else
-  DEBUG('a', "Using demand loading...\n");
+        if(pageTable[i].physicalPage != INT_MAX) {
+            unsigned frame = zeroDaemon->TakeFrame(false, nullptr);
+            memcpy(&mainMemory[frame * PAGE_SIZE], &mainMemory[pageTable[i].physicalPage * PAGE_SIZE], PAGE_SIZE);
+            pageTable[i].physicalPage = frame;
+        }
 #endif
+    }
 }
 
 #ifdef DEMAND_LOADING
 void
-AddressSpace::LoadPage(unsigned vpnAddress, unsigned physicalPage) {
+AddressSpace::LoadPage(unsigned vpnAddress, unsigned physicalPage, bool zeroed) {
 
     ASSERT(vpnAddress >= 0);
     ASSERT(physicalPage != INT_MAX); //i  have a valid frame
 
-    Executable exe (exeFile);
-
     DEBUG('a', "Loading page..., physicalPage: %d, vpnAddress: %d\n", physicalPage, vpnAddress);
 
     // Get the physical address to write into
     uint32_t physicalAddressToWrite = physicalPage * PAGE_SIZE;
-
-    // Clean the memory
     char *mainMemory = machine->GetMMU()->mainMemory;
-    memset(&mainMemory[physicalAddressToWrite], 0, PAGE_SIZE); //looks fine
 
     int vpn = vpnAddress / PAGE_SIZE;
-    unsigned vpnAddressToRead = vpn * PAGE_SIZE;
-
-    unsigned read = 0; // I need to ensure that i have read PAGE_SIZE bytes
 
+    Mapping *mapping = FindMapping(vpn);
+#ifdef SWAP
+    SharedSegment *segment = mapping != nullptr ? mapping->segment : nullptr;
+    if(segment != nullptr) {
+        unsigned page = vpn - mapping->firstVpn;
+        if(segment->slots[page] != -1) {
+            DEBUG('a',"Reading shared page from swap slot %d...\n", segment->slots[page]);
+            swapArea->Read(segment->slots[page], &mainMemory[physicalAddressToWrite]);
+        } else if(zeroed) {
+            stats->numZeroFillsSkipped++;
+        } else {
+            memset(&mainMemory[physicalAddressToWrite], 0, PAGE_SIZE);
+        }
+        segment->frames[page] = physicalPage;
+        pageTable[vpn].dirty = false;
+    } else
+#endif
+    if(mapping != nullptr) {
+        unsigned offset = (vpn - mapping->firstVpn) * PAGE_SIZE;
+        unsigned count  = mapping->length - offset < PAGE_SIZE ? mapping->length - offset : PAGE_SIZE;
+        DEBUG('a',"Reading %u bytes of a mapped file at offset %u...\n", count, offset);
+
+        // Whatever is past the end of the file reads as zero.
+        int bytesRead = mapping->file->ReadAt(&mainMemory[physicalAddressToWrite], count, offset);
+        unsigned filled = bytesRead > 0 ? bytesRead : 0;
+        if(filled < PAGE_SIZE && zeroed)
+            stats->numZeroFillsSkipped++;
+        else if(filled < PAGE_SIZE)
+            memset(&mainMemory[physicalAddressToWrite + filled], 0, PAGE_SIZE - filled);
+        pageTable[vpn].dirty = false;
+    } else
     #ifdef SWAP
-    if(pageTable[vpn].dirty) {
-        DEBUG('a',"Reading from swap at position %d...\n", vpn * PAGE_SIZE);
-        openSwapFile->ReadAt(&mainMemory[physicalAddressToWrite], PAGE_SIZE, vpn * PAGE_SIZE);
-    } else { //read from the exe file
+    if(pageTable.SwapSlot(vpn) != -1) {
+        DEBUG('a',"Reading from swap slot %d...\n", pageTable.SwapSlot(vpn));
+        swapArea->Read(pageTable.SwapSlot(vpn), &mainMemory[physicalAddressToWrite]);
+        pageTable[vpn].dirty = false; // same content as the copy in swap
+    } else //read from the exe file
     #endif
-        if (codeSize > 0 && vpnAddressToRead < codeSize) {
-            DEBUG('a', "Reading code...\n");
-            uint32_t toRead = codeSize - vpnAddressToRead < PAGE_SIZE ? codeSize - vpnAddressToRead : PAGE_SIZE;
+        ReadFromExecutable(vpn, 1, &mainMemory[physicalAddressToWrite], zeroed);
+
+#ifdef SWAP
+    //Update the coremap
+    CoreMapEntry chosenCoreMapEntry = coreMap[physicalPage];
+    chosenCoreMapEntry->spaceId = addressSpaceId;
+    chosenCoreMapEntry->virtualPage = vpn;
+    chosenCoreMapEntry->segment = segment;
+    chosenCoreMapEntry->refCount = 1;
+
+    DEBUG('a',"Marking physical page %u, with virtualPage %u from process %d in the coremap\n", physicalPage, vpn, addressSpaceId);
 
-            DEBUG('a',"Amount to be read: %d \n", toRead);
-            exe.ReadCodeBlock(&mainMemory[physicalAddressToWrite], PAGE_SIZE, vpnAddressToRead);
+    if(pageTable.SwapSlot(vpn) == -1)
+        CacheText(vpn, physicalPage);
+#endif
+
+    DEBUG('a', "Finished loading page! :)\n");
+    return;
+}
+
+void
+AddressSpace::ReadFromExecutable(unsigned firstVpn, unsigned count, char *into, bool zeroed) {
+    ReadSegments(executable, firstVpn * PAGE_SIZE, count * PAGE_SIZE, into, zeroed);
+}
 
-            read += toRead; //to check if there is some data left to read
+bool
+AddressSpace::NeedsZeroFill(unsigned vpn) {
+    Mapping *mapping = FindMapping(vpn);
+#ifdef SWAP
+    if(mapping != nullptr && mapping->segment != nullptr)
+        return mapping->segment->slots[vpn - mapping->firstVpn] == -1;
+#endif
+    if(mapping != nullptr)
+        return (vpn - mapping->firstVpn + 1) * PAGE_SIZE > mapping->length;
+#ifdef SWAP
+    if(pageTable.SwapSlot(vpn) != -1)
+        return false;
+#endif
+    return CoveredBytes(executable, vpn * PAGE_SIZE, PAGE_SIZE) < PAGE_SIZE;
+}
+
+AddressSpace::Mapping *
+AddressSpace::FreeMapping() {
+    for(unsigned i = 0; i < MAX_MAPPINGS; i++) {
+        if(mappings[i].numPages == 0)
+            return &mappings[i];
+    }
+    return nullptr;
+}
+
+unsigned
+AddressSpace::GrowPageTable(unsigned count) {
+    unsigned first = numPages;
+    numPages += count;
+    pageTable.Resize(numPages);
+
+#ifndef USE_TLB
+    RestoreState();
+#endif
+    return first;
+}
+
+int
+AddressSpace::MapFile(OpenFile *file, unsigned length) {
+    ASSERT(file != nullptr);
+    ASSERT(length > 0);
+
+    Mapping *mapping = FreeMapping();
+    if(mapping == nullptr)
+        return -1;
+
+    mapping->file     = file;
+#ifdef SWAP
+    mapping->segment  = nullptr;
+#endif
+    mapping->numPages = DivRoundUp(length, PAGE_SIZE);
+    mapping->firstVpn = GrowPageTable(mapping->numPages);
+    mapping->length   = length;
+
+    DEBUG('a', "Mapped %u bytes of a file at pages %u to %u\n", length,
+          mapping->firstVpn, mapping->firstVpn + mapping->numPages - 1);
+    return mapping->firstVpn * PAGE_SIZE;
+}
+
+bool
+AddressSpace::UnmapFile(unsigned address) {
+    Mapping *mapping = nullptr;
+    for(unsigned i = 0; i < MAX_MAPPINGS && mapping == nullptr; i++) {
+        if(mappings[i].file != nullptr && mappings[i].firstVpn * PAGE_SIZE == address)
+            mapping = &mappings[i];
+    }
+    if(mapping == nullptr)
+        return false;
+
+    // Bring the bits of the TLB back into the page table first.
+    SaveState();
+
+    for(unsigned vpn = mapping->firstVpn; vpn < mapping->firstVpn + mapping->numPages; vpn++) {
+        TranslationEntry *entry = pageTable.Find(vpn);
+        if(entry == nullptr || entry->physicalPage == INT_MAX)
+            continue;
+        if(entry->dirty)
+            WriteBack(mapping, vpn);
+        addressesBitMap->Clear(entry->physicalPage);
+        entry->physicalPage = INT_MAX;
+        entry->valid = false;
+    }
+
+    DEBUG('a', "Unmapped the file at pages %u to %u\n", mapping->firstVpn,
+          mapping->firstVpn + mapping->numPages - 1);
+    RemoveMapping(mapping);
+    zeroDaemon->Wake();
+    return true;
+}
+
+void
+AddressSpace::RemoveMapping(Mapping *mapping) {
+    // The pages are not reused, unless they are the last ones.
+    if(mapping->firstVpn + mapping->numPages == numPages) {
+        numPages = mapping->firstVpn;
+        pageTable.Resize(numPages);
+    }
+    mapping->file = nullptr;
+#ifdef SWAP
+    mapping->segment = nullptr;
+#endif
+    mapping->numPages = 0;
+}
+
+void
+AddressSpace::UnmapAll(OpenFile *file) {
+    // From the last mapping to the first, so that the page table shrinks.
+    for(unsigned i = MAX_MAPPINGS; i-- > 0; ) {
+        if(mappings[i].file != nullptr && (file == nullptr || mappings[i].file == file))
+            UnmapFile(mappings[i].firstVpn * PAGE_SIZE);
+#ifdef SWAP
+        else if(mappings[i].segment != nullptr && file == nullptr)
+            DetachSegment(mappings[i].firstVpn * PAGE_SIZE);
+#endif
+    }
+}
+
+#ifdef SWAP
+int
+AddressSpace::AttachSegment(SharedSegment *segment) {
+    ASSERT(segment != nullptr);
+
+    Mapping *mapping = FreeMapping();
+    if(mapping == nullptr)
+        return -1;
+
+    unsigned firstVpn = numPages;
+    if(!segment->Attach(this, firstVpn))
+        return -1;
+
+    mapping->file     = nullptr;
+    mapping->segment  = segment;
+    mapping->numPages = segment->GetNumPages();
+    mapping->firstVpn = GrowPageTable(mapping->numPages);
+    mapping->length   = mapping->numPages * PAGE_SIZE;
+    ASSERT(mapping->firstVpn == firstVpn);
+
+    DEBUG('a', "Attached a shared segment at pages %u to %u\n",
+          mapping->firstVpn, mapping->firstVpn + mapping->numPages - 1);
+    return mapping->firstVpn * PAGE_SIZE;
+}
+
+bool
+AddressSpace::DetachSegment(unsigned address) {
+    for(unsigned i = 0; i < MAX_MAPPINGS; i++) {
+        if(mappings[i].segment != nullptr && mappings[i].firstVpn * PAGE_SIZE == address) {
+            // Bring the bits of the TLB back into the page table first.
+            SaveState();
+            DropSegment(&mappings[i]);
+            return true;
         }
+    }
+    return false;
+}
+
+void
+AddressSpace::DropSegment(Mapping *mapping) {
+    SharedSegment *segment = mapping->segment;
+
+    // Give up the pages in memory.  They stay in the segment, for the other
+    // processes attached to it.
+    for(unsigned page = 0; page < mapping->numPages; page++) {
+        TranslationEntry *entry = pageTable.Find(mapping->firstVpn + page);
+        if(entry == nullptr || entry->physicalPage == INT_MAX)
+            continue;
 
-        if (initDataSize > 0 && vpnAddressToRead + read < dataVirtualAddr + initDataSize && read != PAGE_SIZE) {
+        unsigned frame = entry->physicalPage;
+        segment->dirty[page] = segment->dirty[page] || entry->dirty;
+        entry->physicalPage = INT_MAX;
+        entry->valid = false;
 
-            // uint32_t toRead = PAGE_SIZE - read; // We're not sure if we need to the check cases like: |code segment... |data segment: 128 ... 128 12|. Suppose we didnt read any code bytes, so
-            //                                         // here we're reading 128 bytes intead of just 12, maybe we're reaing garbage in some point. So we think of:
+        coreMap[frame]->refCount--;
+        if(coreMap[frame]->refCount > 0 && coreMap[frame]->spaceId == addressSpaceId
+             && coreMap[frame]->virtualPage == mapping->firstVpn + page)
+            ChangeOwner(frame);
+    }
+    segment->Detach(this, mapping->firstVpn);
 
-            uint32_t toRead = (dataVirtualAddr + initDataSize) - (vpnAddressToRead + read) < (PAGE_SIZE - read) ?
-                                    (dataVirtualAddr + initDataSize) - (vpnAddressToRead + read)
-                                :
-                                    PAGE_SIZE - read;
+    DEBUG('a', "Detached a shared segment from pages %u to %u\n", mapping->firstVpn,
+          mapping->firstVpn + mapping->numPages - 1);
+    RemoveMapping(mapping);
 
-            DEBUG('a', "Reading %d of data...\n", toRead);
+    if(segment->CountAttached() > 0)
+        return;
 
-            read ? //if read any bytes in the code section and i have not completed the PAGE_SIZE
-                exe.ReadDataBlock(&mainMemory[physicalAddressToWrite + read], toRead,  0)
-            :
-                exe.ReadDataBlock(&mainMemory[physicalAddressToWrite], toRead, vpnAddressToRead - codeSize);
+    // That was the last attachment: nobody can see the segment any more.
+    for(unsigned page = 0; page < segment->GetNumPages(); page++) {
+        if(segment->frames[page] != INT_MAX) {
+            coreMap[segment->frames[page]]->segment = nullptr;
+            addressesBitMap->Clear(segment->frames[page]);
+            segment->frames[page] = INT_MAX;
         }
-    #ifdef SWAP
     }
-    #endif
+    zeroDaemon->Wake();
+    for(unsigned i = 0; i < Table<SharedSegment *>::SIZE; i++) {
+        if(sharedSegments->HasKey(i) && sharedSegments->Get(i) == segment) {
+            sharedSegments->Remove(i);
+            break;
+        }
+    }
+    DEBUG('a', "Destroying a shared segment\n");
+    delete segment;
+}
+#endif
+
+bool
+AddressSpace::IsValidPage(unsigned vpn) {
+    if(vpn < imagePages)
+        return true;
+    if(vpn < imagePages + MAX_HEAP_PAGES)  // the heap, up to the break
+        return vpn * PAGE_SIZE < heapBreak;
+    if(vpn < programPages)  // the stack, above the guard page
+        return vpn > imagePages + MAX_HEAP_PAGES;
+    return vpn < numPages && FindMapping(vpn) != nullptr;
+}
+
+AddressSpace::Mapping *
+AddressSpace::FindMapping(unsigned vpn) {
+    if(vpn < programPages)
+        return nullptr;
+
+    for(unsigned i = 0; i < MAX_MAPPINGS; i++) {
+        Mapping *mapping = &mappings[i];
+        if(mapping->numPages > 0 && vpn >= mapping->firstVpn
+             && vpn < mapping->firstVpn + mapping->numPages)
+            return mapping;
+    }
+    return nullptr;
+}
+
+void
+AddressSpace::WriteBack(Mapping *mapping, unsigned vpn) {
+    ASSERT(pageTable[vpn].physicalPage != INT_MAX);
+
+    unsigned offset = (vpn - mapping->firstVpn) * PAGE_SIZE;
+    unsigned count  = mapping->length - offset < PAGE_SIZE ? mapping->length - offset : PAGE_SIZE;
+    DEBUG('a',"Writing %u bytes back to a mapped file at offset %u...\n", count, offset);
+
+    char *mainMemory = machine->GetMMU()->mainMemory;
+    mapping->file->WriteAt(&mainMemory[pageTable[vpn].physicalPage * PAGE_SIZE], count, offset);
+    pageTable[vpn].dirty = false;
+}
+
+void
+AddressSpace::Readahead(unsigned vpn) {
+    // Grow the window while the faults are sequential, start over otherwise.
+    if(vpn == nextSequentialVpn) {
+        readaheadWindow = readaheadWindow == 0 ? READAHEAD_MIN_PAGES
+                        : 2 * readaheadWindow < READAHEAD_MAX_PAGES ? 2 * readaheadWindow
+                        : READAHEAD_MAX_PAGES;
+    } else {
+        readaheadWindow = 0;
+    }
 
+    // Only the pages that come straight from the executable are worth
+    // prefetching: the rest are zero-filled, or are read from swap one by
+    // one anyway.
+    uint32_t codeEnd = codeVirtualAddr + codeSize;
+    uint32_t dataEnd = dataVirtualAddr + initDataSize;
+    uint32_t exeEnd  = codeEnd > dataEnd ? codeEnd : dataEnd;
 #ifdef SWAP
-    //Update the coremap
-    CoreMapEntry chosenCoreMapEntry = coreMap[physicalPage];
-    chosenCoreMapEntry->spaceId = addressSpaceId;
-    chosenCoreMapEntry->virtualPage = vpn;
+    FileStamp exeStamp = exeFile->GetStamp();
+#endif
 
-    DEBUG('a',"Marking physical page %u, with virtualPage %u from process %d in the coremap\n", physicalPage, vpn, addressSpaceId);
+    unsigned count = 0;
+    while(count < readaheadWindow) {
+        unsigned next = vpn + 1 + count;
+        if(next >= numPages || next * PAGE_SIZE >= exeEnd)
+            break;
+        TranslationEntry *entry = pageTable.Find(next);
+        if(entry != nullptr && entry->physicalPage != INT_MAX)
+            break;
+#ifdef SWAP
+        if((entry != nullptr && pageTable.SwapSlot(next) != -1)
+             || textCache->Find(exeStamp, next) != -1)
+            break;
 #endif
+        count++;
+    }
 
-    DEBUG('a', "Finished loading page! :)\n");
-    return;
+    // Never take a frame away from anybody, and leave the page daemon its
+    // pool.
+    unsigned freeFrames = addressesBitMap->CountClear();
+#ifdef SWAP
+    unsigned reserved = pageDaemon->GetLowWatermark();
+    freeFrames = freeFrames > reserved ? freeFrames - reserved : 0;
+#endif
+    if(count > freeFrames)
+        count = freeFrames;
+
+    nextSequentialVpn = vpn + 1 + count;
+    if(count == 0)
+        return;
+
+    DEBUG('a', "Prefetching pages %u to %u\n", vpn + 1, vpn + count);
+    char *buffer = new char[count * PAGE_SIZE];
+    ReadFromExecutable(vpn + 1, count, buffer, false);
+
+    char *mainMemory = machine->GetMMU()->mainMemory;
+    for(unsigned i = 0; i < count; i++) {
+        unsigned next = vpn + 1 + i;
+        unsigned frame = zeroDaemon->TakeFrame(false, nullptr);
+        memcpy(&mainMemory[frame * PAGE_SIZE], &buffer[i * PAGE_SIZE], PAGE_SIZE);
+
+        // Mapped, but not referenced yet.
+        pageTable[next].physicalPage = frame;
+        pageTable[next].valid = true;
+        pageTable[next].use = false;
+        pageTable[next].dirty = false;
+
+#ifdef SWAP
+        coreMap[frame]->spaceId = addressSpaceId;
+        coreMap[frame]->virtualPage = next;
+        coreMap[frame]->segment = nullptr;
+        coreMap[frame]->refCount = 1;
+        CacheText(next, frame);
+#endif
+#ifdef PRPOLICY_LRU
+        coreMap[frame]->last_use_counter = references_done;
+#endif
+#ifdef PRPOLICY_WSCLOCK
+        coreMap[frame]->last_use_tick = stats->totalTicks;
+#endif
+    }
+    delete [] buffer;
+
+    stats->numPagesPrefetched += count;
 }
 
 #ifdef SWAP
-unsigned
+/// Whether the page held in `frame` can be evicted: the frame is in use, and
+/// it is not waiting in a message queue.
+static inline bool
+IsEvictable(unsigned frame)
+{
+    return addressesBitMap->Test(frame) && !coreMap[frame]->inTransit;
+}
+
+void
+AddressSpace::FrameBits(unsigned frame, bool *use, bool *dirty)
+{
+    AddressSpace **sharers = new AddressSpace *[coreMap[frame]->refCount];
+    unsigned *vpns = new unsigned[coreMap[frame]->refCount];
+    unsigned count = Sharers(frame, sharers, vpns);
+
+    *use   = false;
+    *dirty = false;
+    for (unsigned i = 0; i < count; i++) {
+        TranslationEntry *entry = sharers[i]->getPageTableEntry(vpns[i]);
+        *use   = *use   || entry->use;
+        *dirty = *dirty || entry->dirty;
+    }
+    delete [] sharers;
+    delete [] vpns;
+
+    SharedSegment *segment = coreMap[frame]->segment;
+    if (segment != nullptr) {
+        *dirty = *dirty || segment->dirty[segment->PageOf(frame)];
+    }
+
+    // The TLB copy is the one the hardware keeps up to date.
+    for (unsigned i = 0; i < TLB_SIZE; ++i) {
+        TranslationEntry *cached = &machine->GetMMU()->tlb[i];
+        if (cached->valid && cached->physicalPage == frame) {
+            *use   = *use   || cached->use;
+            *dirty = *dirty || cached->dirty;
+        }
+    }
+}
+
+void
+AddressSpace::ClearFrameUse(unsigned frame)
+{
+    AddressSpace **sharers = new AddressSpace *[coreMap[frame]->refCount];
+    unsigned *vpns = new unsigned[coreMap[frame]->refCount];
+    unsigned count = Sharers(frame, sharers, vpns);
+    for (unsigned i = 0; i < count; i++) {
+        sharers[i]->getPageTableEntry(vpns[i])->use = false;
+    }
+    delete [] sharers;
+    delete [] vpns;
+
+    for (unsigned i = 0; i < TLB_SIZE; ++i) {
+        TranslationEntry *cached = &machine->GetMMU()->tlb[i];
+        if (cached->valid && cached->physicalPage == frame) {
+            cached->use = false;
+        }
+    }
+}
+
+int
 AddressSpace::EvacuatePage() {
     unsigned victim = PickVictim();
     DEBUG('a',"VICTIM PICKED in EvacuatePage: %u\n", victim);
-    SpaceId victimSpace = coreMap[victim]->spaceId;
 
-    if(runningProcesses->HasKey(victimSpace)) { // the victim process is alive
-        // Get the virtual page entry associated with the physical entry of the
-        // victim frame process
-        TranslationEntry* entry = runningProcesses->Get(victimSpace)->space->getPageTableEntry(coreMap[victim]->virtualPage);
-
-        for(unsigned i = 0; i < TLB_SIZE; ++i) { // save the bits if the page is in the TLB
-            if(machine->GetMMU()->tlb[i].physicalPage == victim && machine->GetMMU()->tlb[i].valid) {
-                machine->GetMMU()->tlb[i].valid = false;
-                *entry = machine->GetMMU()->tlb[i];
-            }
+    // The TLB only caches translations of the running address space, which
+    // may be any of the ones sharing the victim: save the bits there.
+    for(unsigned i = 0; i < TLB_SIZE; ++i) {
+        TranslationEntry *cached = &machine->GetMMU()->tlb[i];
+        if(cached->valid && cached->physicalPage == victim) {
+            cached->valid = false;
+            TranslationEntry *entry = currentThread->space->getPageTableEntry(cached->virtualPage);
+            entry->use   = entry->use   || cached->use;
+            entry->dirty = entry->dirty || cached->dirty;
         }
+    }
 
-        //if dirty, we put the modified virtualPage into the N block of the swap file
-        DEBUG('a', "In evacuate page, the entry is: \n dirty: %d\n valid: %d\n", entry->dirty, entry->valid);
-        if(entry->dirty) {
-            char *mainMemory = machine->GetMMU()->mainMemory;
-            unsigned physicalAddressToWrite = victim * PAGE_SIZE;
-            DEBUG('a',"Writing into swap...\n");
-            //save the evacuated information in the N file block
-            runningProcesses->Get(coreMap[victim]->spaceId)->space->openSwapFile->WriteAt(&mainMemory[physicalAddressToWrite], PAGE_SIZE, coreMap[victim]->virtualPage * PAGE_SIZE);
-        }
-        // we do not update the coremap here because it always has to happen, regardless there is an EvacuatePage or not
+    //if dirty, we put the modified virtualPage into the swap area
+    int cleaned = CleanFrame(victim);
+    if(cleaned < 0) {
+        // The swap area is full.  Evicting clean pages instead would only
+        // have the processes take them from each other forever.
+        DEBUG('a', "No room in swap for frame %u\n", victim);
+        return -1;
+    }
+    if(cleaned > 0) {
+        stats->numDirtyEvictions++;
+    } else {
+        // The copy in swap (or in the executable) is still up to date.
+        stats->numCleanEvictions++;
+    }
+    // we do not update the coremap here because it always has to happen, regardless there is an EvacuatePage or not
 
+    AddressSpace **sharers = new AddressSpace *[coreMap[victim]->refCount];
+    unsigned *vpns = new unsigned[coreMap[victim]->refCount];
+    unsigned count = Sharers(victim, sharers, vpns);
+    for(unsigned i = 0; i < count; i++) {
+        TranslationEntry* entry = sharers[i]->getPageTableEntry(vpns[i]);
         entry->physicalPage = INT_MAX; // mark the entry out of the memory for the pageTable
         entry->valid = false; // mark the entry out of the memory for the machine
+        entry->use = false;
+    }
+    delete [] sharers;
+    delete [] vpns;
+
+    SharedSegment *segment = coreMap[victim]->segment;
+    if(segment != nullptr) {
+        segment->frames[segment->PageOf(victim)] = INT_MAX;
+        coreMap[victim]->segment = nullptr;
     }
+    textCache->Remove(victim);
+
     return victim;
 }
 
+unsigned
+AddressSpace::Sharers(unsigned frame, AddressSpace **into, unsigned *vpns) {
+    unsigned vpn = coreMap[frame]->virtualPage;
+    unsigned count = 0;
+
+    // Pages of a shared segment may be mapped at a different page by each
+    // of the processes attached to it.
+    SharedSegment *segment = coreMap[frame]->segment;
+    if(segment != nullptr) {
+        unsigned page = segment->PageOf(frame);
+        AddressSpace *spaces[MAX_SEGMENT_ATTACHMENTS];
+        unsigned firstVpns[MAX_SEGMENT_ATTACHMENTS];
+        unsigned attached = segment->GetAttachments(spaces, firstVpns);
+
+        for(unsigned i = 0; i < attached; i++) {
+            TranslationEntry *entry = spaces[i]->pageTable.Find(firstVpns[i] + page);
+            if(entry != nullptr && entry->physicalPage == frame) {
+                into[count] = spaces[i];
+                vpns[count++] = firstVpns[i] + page;
+            }
+        }
+        ASSERT(count == coreMap[frame]->refCount);
+        return count;
+    }
+
+    // The recorded owner is enough, unless it is giving the page up (see
+    // `ChangeOwner`).
+    AddressSpace *owner = liveSpaces[coreMap[frame]->spaceId];
+    TranslationEntry *ownerEntry = owner != nullptr ? owner->pageTable.Find(vpn) : nullptr;
+    if(coreMap[frame]->refCount == 1 && ownerEntry != nullptr
+         && ownerEntry->physicalPage == frame) {
+        into[0] = owner;
+        vpns[0] = vpn;
+        return 1;
+    }
+
+    for(unsigned i = 0; i < Table<Thread *>::SIZE && count < coreMap[frame]->refCount; i++) {
+        AddressSpace *space = liveSpaces[i];
+        TranslationEntry *entry = space != nullptr ? space->pageTable.Find(vpn) : nullptr;
+        if(entry != nullptr && entry->physicalPage == frame) {
+            into[count] = space;
+            vpns[count++] = vpn;
+        }
+    }
+    ASSERT(count == coreMap[frame]->refCount);
+    return count;
+}
+
+void
+AddressSpace::ChangeOwner(unsigned frame) {
+    AddressSpace **sharers = new AddressSpace *[coreMap[frame]->refCount];
+    unsigned *vpns = new unsigned[coreMap[frame]->refCount];
+    Sharers(frame, sharers, vpns);
+    coreMap[frame]->spaceId = sharers[0]->addressSpaceId;
+    coreMap[frame]->virtualPage = vpns[0];
+    delete [] sharers;
+    delete [] vpns;
+}
+
+int
+AddressSpace::CleanSharedFrame(unsigned frame) {
+    unsigned vpn = coreMap[frame]->virtualPage;
+    AddressSpace **sharers = new AddressSpace *[coreMap[frame]->refCount];
+    unsigned *vpns = new unsigned[coreMap[frame]->refCount];
+    unsigned count = Sharers(frame, sharers, vpns);
+
+    // The page is read-only while shared, but it may have been modified
+    // before the Fork.
+    bool dirty = false;
+    for(unsigned i = 0; i < count; i++)
+        dirty = dirty || sharers[i]->pageTable[vpn].dirty;
+
+    if(dirty) {
+        int slot = swapArea->AllocSlots(1);
+        if(slot == -1) {
+            DEBUG('a', "The swap area is full!\n");
+            delete [] sharers;
+            delete [] vpns;
+            return -1;
+        }
+        DEBUG('a',"Writing shared page %u into swap slot %d...\n", vpn, slot);
+        swapArea->Write(slot, &machine->GetMMU()->mainMemory[frame * PAGE_SIZE], 1);
+
+        for(unsigned i = 0; i < count; i++) {
+            if(sharers[i]->pageTable.SwapSlot(vpn) != -1)
+                swapArea->FreeSlot(sharers[i]->pageTable.SwapSlot(vpn));
+            if(i > 0)
+                swapArea->ShareSlot(slot);
+            sharers[i]->pageTable.SwapSlot(vpn) = slot;
+            sharers[i]->pageTable[vpn].dirty = false;
+        }
+    }
+    delete [] sharers;
+    delete [] vpns;
+
+    return dirty ? 1 : 0;
+}
+
+int
+AddressSpace::CleanSegmentFrame(unsigned frame) {
+    SharedSegment *segment = coreMap[frame]->segment;
+    unsigned page = segment->PageOf(frame);
+
+    AddressSpace *sharers[MAX_SEGMENT_ATTACHMENTS];
+    unsigned vpns[MAX_SEGMENT_ATTACHMENTS];
+    unsigned count = Sharers(frame, sharers, vpns);
+
+    bool dirty = segment->dirty[page];
+    for(unsigned i = 0; i < count; i++)
+        dirty = dirty || sharers[i]->pageTable[vpns[i]].dirty;
+    if(!dirty)
+        return 0;
+
+    // The slot belongs to the segment alone, so it can be overwritten.
+    if(segment->slots[page] == -1) {
+        segment->slots[page] = swapArea->AllocSlots(1);
+        if(segment->slots[page] == -1) {
+            DEBUG('a', "The swap area is full!\n");
+            return -1;
+        }
+    }
+    DEBUG('a',"Writing shared segment page %u into swap slot %d...\n", page, segment->slots[page]);
+    swapArea->Write(segment->slots[page], &machine->GetMMU()->mainMemory[frame * PAGE_SIZE], 1);
+
+    segment->dirty[page] = false;
+    for(unsigned i = 0; i < count; i++)
+        sharers[i]->pageTable[vpns[i]].dirty = false;
+    return 1;
+}
+
+bool
+AddressSpace::CopyOnWrite(unsigned vpn) {
+    ASSERT(vpn < numPages);
+
+    TranslationEntry *entry = &pageTable[vpn];
+    if(entry->physicalPage == INT_MAX) // evicted meanwhile, the retry brings it back
+        return true;
+
+    unsigned frame = entry->physicalPage;
+    if(coreMap[frame]->refCount > 1) {
+        int possibleFrame = zeroDaemon->TakeFrame(false, nullptr);
+        if(possibleFrame == -1) {
+            possibleFrame = EvacuatePage();
+            if(possibleFrame == -1)
+                return false;
+            if(entry->physicalPage == INT_MAX) {
+                // The victim was the shared page itself; it is no longer
+                // shared once it comes back.
+                addressesBitMap->Clear(possibleFrame);
+                return true;
+            }
+        }
+        unsigned copy = possibleFrame;
+        DEBUG('a', "Copying shared page %u from frame %u to %u\n", vpn, frame, copy);
+
+        char *mainMemory = machine->GetMMU()->mainMemory;
+        memcpy(&mainMemory[copy * PAGE_SIZE], &mainMemory[frame * PAGE_SIZE], PAGE_SIZE);
+        entry->physicalPage = copy;
+
+        coreMap[frame]->refCount--;
+        if(coreMap[frame]->spaceId == addressSpaceId)
+            ChangeOwner(frame);
+
+        coreMap[copy]->spaceId = addressSpaceId;
+        coreMap[copy]->virtualPage = vpn;
+        coreMap[copy]->segment = nullptr;
+        coreMap[copy]->refCount = 1;
+#ifdef PRPOLICY_LRU
+        references_done++;
+        coreMap[copy]->last_use_counter = references_done;
+#endif
+#ifdef PRPOLICY_WSCLOCK
+        coreMap[copy]->last_use_tick = stats->totalTicks;
+#endif
+    } else if(textCache->Contains(frame)) {
+        // Nobody else maps the cached page: it becomes private.
+        textCache->Remove(frame);
+    }
+    entry->readOnly = false;
+    return true;
+}
+
+bool
+AddressSpace::IsTextPage(unsigned vpn) {
+    uint32_t start = vpn * PAGE_SIZE;
+    uint32_t end   = start + PAGE_SIZE;
+
+    if(codeSize == 0 || start < codeVirtualAddr || end > codeVirtualAddr + codeSize)
+        return false;
+    return initDataSize == 0 || end <= dataVirtualAddr || start >= dataVirtualAddr + initDataSize;
+}
+
+void
+AddressSpace::CacheText(unsigned vpn, unsigned frame) {
+    if(!IsTextPage(vpn))
+        return;
+
+    textCache->Insert(frame, exeFile->GetStamp(), vpn);
+    pageTable[vpn].readOnly = true;
+}
+
+bool
+AddressSpace::MapSharedPage(unsigned vpn) {
+    ASSERT(vpn < numPages);
+
+    unsigned frame;
+    bool readOnly;
+    Mapping *mapping = FindMapping(vpn);
+
+    if(mapping != nullptr && mapping->segment != nullptr) {
+        frame = mapping->segment->frames[vpn - mapping->firstVpn];
+        if(frame == INT_MAX)
+            return false;
+        DEBUG('a', "Mapping shared page %u from frame %u\n", vpn, frame);
+        readOnly = false;
+    } else {
+        // A private copy of the page, if any, is the one in swap.
+        if(pageTable.SwapSlot(vpn) != -1 || !IsTextPage(vpn))
+            return false;
+
+        int possibleFrame = textCache->Find(exeFile->GetStamp(), vpn);
+        if(possibleFrame == -1)
+            return false;
+        frame = possibleFrame;
+        DEBUG('a', "Mapping cached code page %u from frame %u\n", vpn, frame);
+        readOnly = true;
+        stats->numTextPagesShared++;
+    }
+
+    if(coreMap[frame]->refCount == 0) {  // left behind by processes that are gone
+        coreMap[frame]->spaceId = addressSpaceId;
+        coreMap[frame]->virtualPage = vpn;
+    }
+    coreMap[frame]->refCount++;
+#ifdef PRPOLICY_LRU
+    references_done++;
+    coreMap[frame]->last_use_counter = references_done;
+#endif
+#ifdef PRPOLICY_WSCLOCK
+    coreMap[frame]->last_use_tick = stats->totalTicks;
+#endif
+
+    pageTable[vpn].physicalPage = frame;
+    pageTable[vpn].valid = true;
+    pageTable[vpn].dirty = false;
+    pageTable[vpn].readOnly = readOnly;
+    return true;
+}
+
+int
+AddressSpace::GiveAwayPage(unsigned vpn) {
+    if(!IsValidPage(vpn) || FindMapping(vpn) != nullptr || IsTextPage(vpn))
+        return -1;
+
+    // Bring the bits of the TLB back into the page table first.
+    SaveState();
+
+    TranslationEntry *entry = pageTable.Find(vpn);
+    if(entry == nullptr || entry->physicalPage == INT_MAX)
+        return -1;
+    unsigned frame = entry->physicalPage;
+    if(coreMap[frame]->refCount != 1 || coreMap[frame]->segment != nullptr)
+        return -1;
+
+    // The copy in swap is gone along with the frame, so the next fault
+    // loads the page from the executable.
+    entry->physicalPage = INT_MAX;
+    entry->valid = false;
+    entry->use = false;
+    entry->dirty = false;
+    entry->readOnly = false;
+    if(pageTable.SwapSlot(vpn) != -1) {
+        swapArea->FreeSlot(pageTable.SwapSlot(vpn));
+        pageTable.SwapSlot(vpn) = -1;
+    }
+
+    DEBUG('a', "Giving away page %u, in frame %u\n", vpn, frame);
+    return frame;
+}
+
+bool
+AddressSpace::AdoptPage(unsigned vpn, unsigned frame) {
+    ASSERT(coreMap[frame]->inTransit);
+
+    if(!IsValidPage(vpn) || FindMapping(vpn) != nullptr || IsTextPage(vpn))
+        return false;
+
+    // Bring the bits of the TLB back into the page table first.
+    SaveState();
+
+    TranslationEntry *entry = &pageTable[vpn];
+    unsigned old = entry->physicalPage;
+    entry->physicalPage = frame;
+    entry->valid = true;
+    entry->use = false;
+    entry->dirty = true;   // the frame holds the only copy of the page
+    entry->readOnly = false;
+
+    if(old != INT_MAX) {
+        if(coreMap[old]->refCount > 1) {  // still used by other processes
+            coreMap[old]->refCount--;
+            if(coreMap[old]->spaceId == addressSpaceId)
+                ChangeOwner(old);
+        } else {
+            addressesBitMap->Clear(old);
+        }
+    }
+    if(pageTable.SwapSlot(vpn) != -1) {
+        swapArea->FreeSlot(pageTable.SwapSlot(vpn));
+        pageTable.SwapSlot(vpn) = -1;
+    }
+
+    coreMap[frame]->spaceId = addressSpaceId;
+    coreMap[frame]->virtualPage = vpn;
+    coreMap[frame]->segment = nullptr;
+    coreMap[frame]->refCount = 1;
+#ifdef PRPOLICY_LRU
+    references_done++;
+    coreMap[frame]->last_use_counter = references_done;
+#endif
+#ifdef PRPOLICY_WSCLOCK
+    coreMap[frame]->last_use_tick = stats->totalTicks;
+#endif
+
+    DEBUG('a', "Adopting frame %u at page %u\n", frame, vpn);
+    return true;
+}
+
+int
+AddressSpace::CleanFrame(unsigned frame) {
+    if(coreMap[frame]->segment != nullptr)
+        return CleanSegmentFrame(frame);
+    if(coreMap[frame]->refCount == 0)  // cached code, never modified
+        return 0;
+    if(coreMap[frame]->refCount > 1)
+        return CleanSharedFrame(frame);
+
+    AddressSpace *space = liveSpaces[coreMap[frame]->spaceId];
+    unsigned vpn = coreMap[frame]->virtualPage;
+
+    Mapping *mapping = space->FindMapping(vpn);
+    if(mapping != nullptr) {
+        if(!space->pageTable[vpn].dirty)
+            return 0;
+        space->WriteBack(mapping, vpn);
+        return 1;
+    }
+
+    if(!space->IsDirtyResident(vpn))
+        return 0;
+
+    // Take along the dirty neighbours of the page, so that they all go to
+    // swap in a single write.
+    unsigned first = vpn, last = vpn;
+    while(last - first + 1 < SWAP_CLUSTER_PAGES && first > 0 && space->IsDirtyResident(first - 1))
+        first--;
+    while(last - first + 1 < SWAP_CLUSTER_PAGES && last + 1 < space->numPages && space->IsDirtyResident(last + 1))
+        last++;
+
+    if(!space->SwapOut(first, last - first + 1) && space->IsDirtyResident(vpn))
+        return -1;
+    return last - first + 1;
+}
+
+bool
+AddressSpace::IsDirtyResident(unsigned vpn) {
+    TranslationEntry *entry = pageTable.Find(vpn);
+    return entry != nullptr && entry->physicalPage != INT_MAX && entry->dirty
+             && coreMap[entry->physicalPage]->refCount == 1
+             && FindMapping(vpn) == nullptr;
+}
+
+bool
+AddressSpace::SwapOut(unsigned first, unsigned count) {
+    char *mainMemory = machine->GetMMU()->mainMemory;
+
+    // The copies already in swap are stale, give their slots back first so
+    // that they can be part of the new run.
+    for(unsigned vpn = first; vpn < first + count; vpn++) {
+        if(pageTable.SwapSlot(vpn) != -1) {
+            swapArea->FreeSlot(pageTable.SwapSlot(vpn));
+            pageTable.SwapSlot(vpn) = -1;
+        }
+    }
+
+    int slot = count > 1 ? swapArea->AllocSlots(count) : -1;
+    if(slot != -1) {
+        DEBUG('a',"Writing pages %u to %u into swap slot %d...\n", first, first + count - 1, slot);
+        char *buffer = new char[count * PAGE_SIZE];
+        for(unsigned i = 0; i < count; i++)
+            memcpy(&buffer[i * PAGE_SIZE], &mainMemory[pageTable[first + i].physicalPage * PAGE_SIZE], PAGE_SIZE);
+        swapArea->Write(slot, buffer, count);
+        delete [] buffer;
+
+        for(unsigned i = 0; i < count; i++) {
+            pageTable.SwapSlot(first + i) = slot + i;
+            pageTable[first + i].dirty = false;
+        }
+        return true;
+    }
+
+    // No free run that long (or a single page), write them one by one.
+    for(unsigned vpn = first; vpn < first + count; vpn++) {
+        slot = swapArea->AllocSlots(1);
+        if(slot == -1) {
+            DEBUG('a', "The swap area is full!\n");
+            return false;
+        }
+        DEBUG('a',"Writing page %u into swap slot %d...\n", vpn, slot);
+        swapArea->Write(slot, &mainMemory[pageTable[vpn].physicalPage * PAGE_SIZE], 1);
+        pageTable.SwapSlot(vpn) = slot;
+        pageTable[vpn].dirty = false;
+    }
+    return true;
+}
+
+/// Choose the frame to evict.  Free frames are never chosen (the page
+/// daemon may have left some), so at least one frame must be in use; nor
+/// are frames held by messages, which are a small part of memory.
 unsigned
 AddressSpace::PickVictim() {
+    ASSERT(addressesBitMap->CountClear() < NUM_PHYS_PAGES);
     unsigned victim = 0;
 #ifdef PRPOLICY_FIFO
-    victim = fifo_counter % NUM_PHYS_PAGES;
-    fifo_counter++;
+    do {
+        victim = fifo_counter % NUM_PHYS_PAGES;
+        fifo_counter++;
+    } while(!IsEvictable(victim));
 #elif PRPOLICY_LRU
     if(references_done == UINT_MAX) {
         references_done = 0;
@@ -274,14 +1229,94 @@ AddressSpace::PickVictim() {
 
     unsigned min = UINT_MAX;
     for(unsigned i = 0; i < NUM_PHYS_PAGES; i++) {
-        if(coreMap[i]->last_use_counter < min) {
+        if(IsEvictable(i) && coreMap[i]->last_use_counter < min) {
             min = coreMap[i]->last_use_counter;
             victim = i;
         }
     }
 
+#elif PRPOLICY_CLOCK
+    // Enhanced second chance.  Even laps look for a page that is neither
+    // referenced nor modified, without touching anything.  Odd laps also
+    // accept modified pages, and take the second chance away from the pages
+    // the hand passes over.  At most four laps are needed, because after the
+    // second one every `use` bit is clear.
+    for (unsigned lap = 0; ; lap++) {
+        for (unsigned i = 0; i < NUM_PHYS_PAGES; i++) {
+            unsigned frame = clock_hand;
+            clock_hand = (clock_hand + 1) % NUM_PHYS_PAGES;
+            if (!IsEvictable(frame)) {
+                continue;
+            }
+            if (coreMap[frame]->refCount == 0) {
+                return frame;  // cached code that nobody maps
+            }
+
+            bool use, dirty;
+            FrameBits(frame, &use, &dirty);
+            if (!use && (!dirty || lap % 2 == 1)) {
+                return frame;
+            }
+            if (lap % 2 == 1) {
+                ClearFrameUse(frame);
+            }
+        }
+    }
+
+#elif PRPOLICY_WSCLOCK
+    // WSClock.  Referenced pages get their `use` bit cleared and their time
+    // of last use refreshed.  A page that was not used during the last
+    // `WORKING_SET_WINDOW` ticks is out of the working set; the first clean
+    // one found is the victim.  If every old page is dirty, take the first
+    // of them; if no page is old, prefer any clean one over the hand.
+    unsigned long now = stats->totalTicks;
+    int oldDirty = -1;
+    int youngClean = -1;
+
+    for (unsigned i = 0; i < NUM_PHYS_PAGES; i++) {
+        unsigned frame = clock_hand;
+        clock_hand = (clock_hand + 1) % NUM_PHYS_PAGES;
+        if (!IsEvictable(frame)) {
+            continue;
+        }
+        if (coreMap[frame]->refCount == 0) {
+            return frame;  // cached code that nobody maps
+        }
+
+        bool use, dirty;
+        FrameBits(frame, &use, &dirty);
+        if (use) {
+            ClearFrameUse(frame);
+            coreMap[frame]->last_use_tick = now;
+            continue;
+        }
+
+        bool old = now - coreMap[frame]->last_use_tick > WORKING_SET_WINDOW;
+        if (old && !dirty) {
+            return frame;
+        }
+        if (old && oldDirty == -1) {
+            oldDirty = frame;
+        } else if (!old && !dirty && youngClean == -1) {
+            youngClean = frame;
+        }
+    }
+
+    if (oldDirty != -1) {
+        victim = oldDirty;
+    } else if (youngClean != -1) {
+        victim = youngClean;
+    } else {
+        do {
+            victim = clock_hand;
+            clock_hand = (clock_hand + 1) % NUM_PHYS_PAGES;
+        } while (!IsEvictable(victim));
+    }
+
 #else
-    victim = rand() % NUM_PHYS_PAGES;
+    do {
+        victim = rand() % NUM_PHYS_PAGES;
+    } while(!IsEvictable(victim));
 #endif
 
     return victim;
@@ -300,20 +1335,122 @@ AddressSpace::GetSpaceId() {
 /// Nothing for now!
 AddressSpace::~AddressSpace()
 {
-    char *mainMemory = machine->GetMMU()->mainMemory;
+    DEBUG('a', "Freeing address space of %u pages, with %u second-level page tables\n",
+          numPages, pageTable.CountTables());
+
+#ifdef SWAP
+    // Segments keep their pages; the ones this was the last user of go
+    // away with it.
+    for (unsigned i = 0; i < MAX_MAPPINGS; i++) {
+        if(mappings[i].numPages > 0 && mappings[i].segment != nullptr)
+            DropSegment(&mappings[i]);
+    }
+    liveSpaces[addressSpaceId] = nullptr;
+#endif
 
     for (unsigned i = 0; i < numPages; i++) {
-#ifdef DEMAND_LOADING
-        if(pageTable[i].physicalPage == INT_MAX)
+        TranslationEntry *entry = pageTable.Find(i);
+        if(entry == nullptr || entry->physicalPage == INT_MAX)
             continue;
+#ifdef SWAP
+        unsigned frame = pageTable[i].physicalPage;
+        if(coreMap[frame]->refCount > 1) { // still used by other processes
+            coreMap[frame]->refCount--;
+            if(coreMap[frame]->spaceId == addressSpaceId)
+                ChangeOwner(frame);
+            continue;
+        }
+        if(textCache->Contains(frame)) {   // kept for the next run of the program
+            coreMap[frame]->refCount = 0;
+            continue;
+        }
 #endif
+      // The zero daemon clears the frame later, in case the next user
+      // needs it zeroed.
       addressesBitMap->Clear(pageTable[i].physicalPage);
-      memset(&mainMemory[pageTable[i].physicalPage * PAGE_SIZE], 0, PAGE_SIZE); //looks fine
     }
+    zeroDaemon->Wake();
 #ifdef DEMAND_LOADING
-    delete exeFile;
+    if(--*exeFileUsers == 0) {
+        delete executable;
+        delete exeFile;
+        delete exeFileUsers;
+    }
+#endif
+#ifdef SWAP
+    for (unsigned i = 0; i < numPages; i++) {
+        if(pageTable.Find(i) != nullptr && pageTable.SwapSlot(i) != -1)
+            swapArea->FreeSlot(pageTable.SwapSlot(i));
+    }
+#endif
+}
+
+int
+AddressSpace::Sbrk(int increment)
+{
+    uint32_t oldBreak = heapBreak;
+    uint32_t heapEnd = (imagePages + MAX_HEAP_PAGES) * PAGE_SIZE;
+    if (increment < 0 || (unsigned) increment > heapEnd - heapBreak)
+        return -1;
+
+#ifndef DEMAND_LOADING
+    // Without page faults, the new pages of the heap are needed right away.
+    unsigned firstNew = DivRoundUp(oldBreak, PAGE_SIZE);
+    unsigned lastNew  = DivRoundUp(oldBreak + increment, PAGE_SIZE);
+    if (lastNew - firstNew > addressesBitMap->CountClear())
+        return -1;
+
+    char *mainMemory = machine->GetMMU()->mainMemory;
+    for (unsigned vpn = firstNew; vpn < lastNew; vpn++) {
+        bool zeroed;
+        pageTable[vpn].physicalPage = zeroDaemon->TakeFrame(true, &zeroed);
+        pageTable[vpn].valid        = true;
+        if (zeroed)
+            stats->numZeroFillsSkipped++;
+        else
+            memset(&mainMemory[pageTable[vpn].physicalPage * PAGE_SIZE], 0, PAGE_SIZE);
+    }
 #endif
-    delete [] pageTable;
+
+    heapBreak += increment;
+    DEBUG('a', "Heap break moved from %u to %u\n", oldBreak, heapBreak);
+    return oldBreak;
+}
+
+int
+AddressSpace::TakeThreadStack()
+{
+    for (unsigned i = 0; i < MAX_USER_THREADS; i++) {
+        if (threadStackUsed[i])
+            continue;
+
+        if (threadStacks[i] == 0) {
+            int bottom = Sbrk(USER_THREAD_STACK_SIZE);
+            if (bottom == -1)
+                return -1;
+            // Leave a bit at the top, as `InitRegisters` does, and keep the
+            // stack pointer aligned.
+            threadStacks[i] = (bottom + USER_THREAD_STACK_SIZE - 16) & ~7;
+        }
+        threadStackUsed[i] = true;
+        DEBUG('a', "Thread stack %u, with top at %d, taken\n",
+              i, threadStacks[i]);
+        return threadStacks[i];
+    }
+    return -1;
+}
+
+void
+AddressSpace::ReleaseThreadStack(int top)
+{
+    for (unsigned i = 0; i < MAX_USER_THREADS; i++) {
+        if (threadStacks[i] == top) {
+            ASSERT(threadStackUsed[i]);
+            threadStackUsed[i] = false;
+            return;
+        }
+    }
+    ASSERT(false);
 }
 
 /// Set the initial values for the user-level register set.
@@ -359,8 +1496,7 @@ AddressSpace::SaveState()
 #ifdef SWAP
     for(unsigned i=0; i < TLB_SIZE; i++){
         if(machine->GetMMU()->tlb[i].valid){
-            unsigned physicalPageToSave = machine->GetMMU()->tlb[i].physicalPage;
-            TranslationEntry* entry = getPageTableEntry(coreMap[physicalPageToSave]->virtualPage);
+            TranslationEntry* entry = getPageTableEntry(machine->GetMMU()->tlb[i].virtualPage);
             machine->GetMMU()->tlb[i].valid = false;
             *entry = machine->GetMMU()->tlb[i];
         }
@@ -377,7 +1513,7 @@ AddressSpace::RestoreState()
 {
 
 #ifndef USE_TLB
-    machine->GetMMU()->pageTable     = pageTable;
+    machine->GetMMU()->pageTable     = pageTable.GetDirectory();
     machine->GetMMU()->pageTableSize = numPages;
 #else
 
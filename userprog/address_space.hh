@@ -18,15 +18,51 @@
 #include "machine/translation_entry.hh"
 #include "syscall.h"
 #include "executable.hh"
+#include "page_table.hh"
 #include "lib/bitmap.hh"
 
 #ifdef SWAP
+#include "vmem/shared_segment.hh"
 #include <time.h>
 #include <stdlib.h>
 #endif
 
 
-const unsigned USER_STACK_SIZE = 2048;  ///< Increase this as necessary!
+/// Address spaces are laid out as follows: the program (code, initialized
+/// and uninitialized data), room for the heap to grow up to
+/// `MAX_HEAP_PAGES`, a guard page that is never mapped, and the stack,
+/// which grows down from the top for up to `MAX_STACK_PAGES`.  With demand
+/// loading, heap and stack pages only take a frame once they are touched,
+/// and a stack that overflows hits the guard page, which ends the process.
+const unsigned MAX_HEAP_PAGES  = 256;
+const unsigned MAX_STACK_PAGES = 64;
+
+/// Without demand loading, the size of the stack, which is allocated along
+/// with the program.
+const unsigned USER_STACK_SIZE = 2048;
+
+/// Threads a process can have running at once besides its main thread (see
+/// `ThreadCreate`), and the size of the stack each of them takes from the
+/// heap.
+const unsigned MAX_USER_THREADS       = 8;
+const unsigned USER_THREAD_STACK_SIZE = 1024;
+
+#ifdef DEMAND_LOADING
+/// Bounds of the readahead window, in pages.  It starts at the minimum on
+/// the first sequential fault, and doubles on every following one.
+const unsigned READAHEAD_MIN_PAGES = 2;
+const unsigned READAHEAD_MAX_PAGES = 8;
+
+/// Maximum number of files and shared segments an address space can have
+/// mapped at once.
+const unsigned MAX_MAPPINGS = 8;
+#endif
+
+#ifdef PRPOLICY_WSCLOCK
+/// Pages not referenced during this many ticks are considered out of the
+/// working set of their process by the WSClock replacement policy.
+const unsigned long WORKING_SET_WINDOW = 2000;
+#endif
 
 class AddressSpace {
 public:
@@ -43,27 +79,133 @@ public:
     ///   program; it contains the object code to load into memory.
     AddressSpace(OpenFile *executable_file, SpaceId spaceId);
 
+    /// Create the address space of a child process, as a copy of `parent`,
+    /// which must be the running address space.
+    ///
+    /// With `SWAP`, the pages in memory are shared and become read-only in
+    /// both address spaces, until either of them writes to them (see
+    /// `CopyOnWrite`).  Otherwise they are copied right away.
+    AddressSpace(AddressSpace *parent, SpaceId spaceId);
+
     /// De-allocate an address space.
     ~AddressSpace();
 
     /// Initialize user-level CPU registers, before jumping to user code.
     void InitRegisters();
 
+    /// Move the end of the heap `increment` bytes up, and return where it
+    /// was, or -1 if the heap cannot grow that much.  The new pages read as
+    /// zero.
+    int Sbrk(int increment);
+
+    /// Return the top of a stack for a new thread of the process, or -1 if
+    /// it has `MAX_USER_THREADS` already.  Stacks are taken from the heap
+    /// the first time, and reused once their threads exit.
+    int TakeThreadStack();
+
+    /// The thread whose stack has its top at `top` exited.
+    void ReleaseThreadStack(int top);
+
     /// Save/restore address space-specific info on a context switch.
 
     void SaveState();
     void RestoreState();
 #ifdef SWAP
-    unsigned EvacuatePage();
-    unsigned PickVictim();
+    /// Free a physical page by evicting the page chosen by the replacement
+    /// policy, and return it.  The frame stays marked as used.  Return -1,
+    /// and evict nothing, if the page has to go to swap and the swap area
+    /// is full.
+    static int EvacuatePage();
+    static unsigned PickVictim();
+
+    /// Write the page held in `frame` to swap if it was modified, and clear
+    /// its dirty bit.  Modified pages next to it in the same address space
+    /// are written along with it.  Return the number of pages written, or
+    /// -1 if the swap area is full, in which case the page stays dirty.
+    static int CleanFrame(unsigned frame);
+
+    /// Tell whether the page held in `frame` was referenced, and whether it
+    /// was modified, by any of the address spaces that map it, counting the
+    /// bits the TLB keeps.
+    static void FrameBits(unsigned frame, bool *use, bool *dirty);
+
+    /// Clear the `use` bit of every mapping of `frame`, in the page tables
+    /// and in the TLB, so that the next reference sets it again.
+    static void ClearFrameUse(unsigned frame);
     SpaceId GetSpaceId();
+
+    /// Handle a write to the read-only page `vpn`: give this address space
+    /// its own copy of the page if it is shared, and make it writable.
+    /// Return false if no frame could be freed for the copy.
+    bool CopyOnWrite(unsigned vpn);
+
+    /// If page `vpn` is already in memory for other processes, map the same
+    /// frame and return true.  That is the case of code pages found in the
+    /// text cache, which are mapped read-only, and of pages of shared
+    /// segments.
+    bool MapSharedPage(unsigned vpn);
+
+    /// Take page `vpn` out of this address space, for a message, and return
+    /// the frame that holds it, or -1 if the page is not in memory, is
+    /// mapped by other processes too, or is not a page of data, heap or
+    /// stack.  From then on, the page reads as it did when the program
+    /// started.
+    int GiveAwayPage(unsigned vpn);
+
+    /// Map `frame`, which holds a page of a message and is mapped nowhere,
+    /// at page `vpn`, in place of what was there, and return true; or return
+    /// false if `vpn` is not a page of data, heap or stack.
+    bool AdoptPage(unsigned vpn, unsigned frame);
 #endif
 
 #ifdef DEMAND_LOADING
-    void LoadPage(unsigned, unsigned);
+    /// Fill `physicalPage` with the content of the page at `vpnAddress`.
+    /// `zeroed` tells that the frame is all zero already, so the parts of
+    /// the page that read as zero need not be cleared.
+    void LoadPage(unsigned vpnAddress, unsigned physicalPage, bool zeroed);
+
+    /// Whether loading page `vpn` leaves part of it zero-filled, so that it
+    /// had better go into a zeroed frame.
+    bool NeedsZeroFill(unsigned vpn);
+
+    /// Map the first `length` bytes of `file` into new pages at the end of
+    /// the address space, and return the address of the first one, or -1
+    /// if too many files are mapped already.  Pages are read from the file
+    /// on their first reference, and written back to it when they are
+    /// evicted or unmapped, if they were modified.
+    int MapFile(OpenFile *file, unsigned length);
+
+    /// Write back and remove the mapping that starts at `address`.  Return
+    /// false if there is none.
+    bool UnmapFile(unsigned address);
+
+    /// Remove every mapping of `file`, or every mapping, shared segments
+    /// included, if it is null.
+    void UnmapAll(OpenFile *file);
+
+#ifdef SWAP
+    /// Map the shared memory `segment` into new pages at the end of the
+    /// address space, and return the address of the first one, or -1 if
+    /// there are too many mappings.
+    int AttachSegment(SharedSegment *segment);
+
+    /// Remove the segment mapped at `address`.  The segment is destroyed
+    /// along with its last attachment.  Return false if there is none.
+    bool DetachSegment(unsigned address);
+#endif
+
+    /// Whether page `vpn` belongs to the program or to a mapped file.
+    bool IsValidPage(unsigned vpn);
+
+    /// Called after loading page `vpn` on a fault.  If the faults of this
+    /// address space look sequential, load the pages that follow into free
+    /// frames as well, with a single read of the executable.
+    void Readahead(unsigned vpn);
+
     uint32_t codeSize;
     uint32_t initDataSize;
 
+    uint32_t codeVirtualAddr;
     uint32_t dataVirtualAddr;
 #endif
 
@@ -72,17 +214,117 @@ private:
 
 #ifdef DEMAND_LOADING
 #ifdef SWAP
-    OpenFile* openSwapFile;
+    /// Store in `into` the address spaces that map `frame`, and in `vpns`
+    /// the page each of them maps it at, and return how many they are (the
+    /// `refCount` of the frame).
+    static unsigned Sharers(unsigned frame, AddressSpace **into, unsigned *vpns);
+
+    /// The address space recorded as owner of the shared page `frame` no
+    /// longer maps it: record one of the others instead.
+    static void ChangeOwner(unsigned frame);
+
+    /// Write a page shared by several address spaces to a single slot, if
+    /// any of them modified it.  Like `CleanFrame`, return -1 if the swap
+    /// area is full.
+    static int CleanSharedFrame(unsigned frame);
+
+    /// Write a page of a shared segment to the slot of the segment, if it
+    /// was modified, or return -1 if it has none and the swap area is full.
+    static int CleanSegmentFrame(unsigned frame);
+
+    /// Whether page `vpn` is in memory, not shared, not backed by a mapped
+    /// file, and was modified since it was last read from or written to
+    /// swap.
+    bool IsDirtyResident(unsigned vpn);
+
+    /// Whether page `vpn` only holds code, as found in the executable.
+    bool IsTextPage(unsigned vpn);
+
+    /// Page `vpn` was just read from the executable into `frame`: if it is
+    /// a code page, add it to the text cache and make it read-only.
+    void CacheText(unsigned vpn, unsigned frame);
+
+    /// Write the resident pages `first` to `first + count - 1` to swap,
+    /// in contiguous slots if possible.  Return false if the swap area
+    /// filled up before all of them were written; the rest stay dirty.
+    bool SwapOut(unsigned first, unsigned count);
+
     SpaceId   addressSpaceId;
 #endif
-    OpenFile* exeFile;
+    OpenFile*   exeFile;
+    Executable* executable;    // header of `exeFile`, read once
+    unsigned*   exeFileUsers;  // address spaces sharing `exeFile`, after a Fork
+
+    /// Fill `count` pages starting at page `firstVpn` with their initial
+    /// content, as found in the executable.  If `zeroed`, `into` is all zero
+    /// already.
+    void ReadFromExecutable(unsigned firstVpn, unsigned count, char *into,
+                            bool zeroed);
+
+    /// A file mapped by `MapFile`, or a shared segment.  Free entries have
+    /// no pages.
+    struct Mapping {
+        OpenFile *file;
+#ifdef SWAP
+        SharedSegment *segment;
+#endif
+        unsigned firstVpn;
+        unsigned numPages;
+        unsigned length;   // bytes of the file that are mapped
+    };
+    Mapping mappings[MAX_MAPPINGS];
+
+    /// Pages of the program, its heap and its stack; mapped files come
+    /// after them.
+    unsigned programPages;
+
+    /// Return a free entry of `mappings`, or null.
+    Mapping *FreeMapping();
+
+    /// Free `mapping`, whose pages are no longer in memory.
+    void RemoveMapping(Mapping *mapping);
+
+#ifdef SWAP
+    /// Detach from the segment of `mapping`, assuming the page table is up
+    /// to date with the TLB.
+    void DropSegment(Mapping *mapping);
+#endif
+
+    /// Make room for `count` more pages at the end of the page table, and
+    /// return the first of them.
+    unsigned GrowPageTable(unsigned count);
+
+    /// Return the mapping that holds page `vpn`, or null.
+    Mapping *FindMapping(unsigned vpn);
+
+    /// Write the resident page `vpn` of `mapping` back to the file, and
+    /// clear its dirty bit.
+    void WriteBack(Mapping *mapping, unsigned vpn);
+
+    /// Number of pages the next readahead will try to prefetch.
+    unsigned readaheadWindow;
+
+    /// A fault on this page continues the current sequential run.
+    unsigned nextSequentialVpn;
 #endif
-    /// Assume linear page table translation for now!
-    TranslationEntry *pageTable;
+    /// Two-level page table; with `SWAP`, it also records the swap slot
+    /// holding the copy of each page, -1 if none.
+    PageTable pageTable;
 
     /// Number of pages in the virtual address space.
     unsigned numPages;
 
+    /// Pages of code and data; the heap starts right after them.
+    unsigned imagePages;
+
+    /// First address past the end of the heap.
+    uint32_t heapBreak;
+
+    /// Tops of the stacks of threads, 0 for those not taken from the heap
+    /// yet, and whether a thread is using each of them.
+    int threadStacks[MAX_USER_THREADS];
+    bool threadStackUsed[MAX_USER_THREADS];
+
 };
 
 
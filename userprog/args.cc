@@ -5,6 +5,7 @@
 
 #include "transfer.hh"
 #include "machine/machine.hh"
+#include "machine/endianness.hh"
 #include "threads/system.hh"
 
 #include <string.h>
@@ -13,20 +14,26 @@
 static const unsigned MAX_ARG_COUNT  = 32;
 static const unsigned MAX_ARG_LENGTH = 128;
 
-/// Count the number of arguments up to a null (which is not counted).
+/// Count the number of arguments up to a null (which is not counted), and
+/// store their addresses in `addresses`.
 ///
 /// Returns true if the number fit in the established limits and false if
-/// too many arguments were provided.
+/// too many arguments were provided, or the array cannot be read.
 static inline
-bool CountArgsToSave(int address, unsigned *count)
+bool CountArgsToSave(int address, unsigned *count, int *addresses)
 {
     ASSERT(address != 0);
     ASSERT(count != nullptr);
+    ASSERT(addresses != nullptr);
 
     int val;
     unsigned c = 0;
     do {
-        for(unsigned i = 0; !machine->ReadMem(address + 4 * c, 4, &val) && i < NUMBER_OF_TRIES; ++i);
+        if (!ReadBufferFromUser(address + 4 * c, (char *) &val, 4)) {
+            return false;
+        }
+        val = WordToHost(val);
+        addresses[c] = val;
         c++;
     } while (c < MAX_ARG_COUNT && val != 0);
     if (c == MAX_ARG_COUNT && val != 0) {
@@ -45,7 +52,8 @@ SaveArgs(int address)
     ASSERT(address != 0);
 
     unsigned count;
-    if (!CountArgsToSave(address, &count)) {
+    int addresses[MAX_ARG_COUNT];
+    if (!CountArgsToSave(address, &count, addresses)) {
         return nullptr;
     }
 
@@ -58,10 +66,14 @@ SaveArgs(int address)
 
     for (unsigned i = 0; i < count; i++) {
         args[i] = new char [MAX_ARG_LENGTH];
-        int strAddr;
         // For each pointer, read the corresponding string.
-        for(unsigned j = 0; !machine->ReadMem(address + i * 4, 4, &strAddr) && j < NUMBER_OF_TRIES; ++j);
-        ReadStringFromUser(strAddr, args[i], MAX_ARG_LENGTH);
+        if (!ReadStringFromUser(addresses[i], args[i], MAX_ARG_LENGTH)) {
+            for (unsigned j = 0; j <= i; j++) {
+                delete [] args[j];
+            }
+            delete [] args;
+            return nullptr;
+        }
     }
     args[count] = nullptr;  // Write the trailing null.
 
@@ -78,6 +90,7 @@ WriteArgs(char **args)
     // Start writing the strings where the current SP points.  Write them in
     // reverse order (i.e. the string from the first argument will be in a
     // higher memory address than the string from the second argument).
+    // The top of the stack of a new process is always there to write to.
     int argsAddress[MAX_ARG_COUNT];
     unsigned c;
     int sp = machine->ReadRegister(STACK_REG);
@@ -96,13 +109,13 @@ WriteArgs(char **args)
     sp -= sp % 4;     // Align the stack to a multiple of four.
     sp -= c * 4 + 4;  // Make room for `argv`, including the trailing null.
     DEBUG('e', "sp beggins at: %d\n", sp);
-    // Write each argument's address.
-
+    // Write each argument's address, all of them in one go, in the byte
+    // order of the machine.
     for (unsigned i = 0; i < c; i++) {
-        for(unsigned j = 0; !machine->WriteMem(sp + 4 * i, 4, argsAddress[i]) && j < NUMBER_OF_TRIES; ++j);
+        argsAddress[i] = WordToMachine(argsAddress[i]);
     }
-
-    for(unsigned i = 0; !machine->WriteMem(sp + 4 * c, 4, 0) && i < NUMBER_OF_TRIES; ++i);  // The last is null.
+    argsAddress[c] = 0;  // The last is null.
+    WriteBufferToUser((const char *) argsAddress, sp, 4 * (c + 1));
 
     machine->WriteRegister(STACK_REG, sp);
     return c;
@@ -14,7 +14,8 @@
 /// Save command-line arguments from the memory of a user process.
 ///
 /// It moves an `argv`-like array from user memory to kernel memory, and
-/// returns a pointer to the latter.
+/// returns a pointer to the latter, or null if there are too many arguments,
+/// one is too long, or they are not in the memory of the process.
 ///
 /// Parameters:
 /// * `address` is a user-space address pointing to the start of an
@@ -26,15 +26,21 @@
 #include "syscall.h"
 #include "args.hh"
 #include "exception.hh"
+#include "pipe.hh"
 #include "filesys/directory_entry.hh"
 #include "filesys/open_file.hh"
 #include "threads/system.hh"
 #include "machine/mmu.hh"    //for the page size
+#include "machine/endianness.hh"
+#include "machine/disk.hh"       //for the sector size
 
 #include <limits.h>
 #include <stdlib.h>
 #include <stdio.h>
 
+/// Bytes `CopyFile` moves at a time.
+static const int COPY_CHUNK_SIZE = 8 * SECTOR_SIZE;
+
 static void
 IncrementPC()
 {
@@ -66,6 +72,62 @@ DefaultHandler(ExceptionType et)
     ASSERT(false);
 }
 
+/// End the current process with `status`, or only the current thread, if
+/// it was created by `ThreadCreate`.
+///
+/// Files the process has mapped are written back first.
+static void
+ExitProcess(int status)
+{
+    if (currentThread->GetProcess() != currentThread) {
+        // Wait for the asynchronous requests of the thread on files, which
+        // the process keeps open until every thread exits.
+        if (currentThread->ioRing != nullptr) {
+            currentThread->ioRing->Release();
+            currentThread->ioRing = nullptr;
+        }
+
+        // Once the main thread is told, it must not get to end the process,
+        // and maybe halt the machine, before this thread is gone.
+        interrupt->SetLevel(INT_OFF);
+        currentThread->ExitUserThread();
+        currentThread->Finish(status);
+    }
+
+    // The other threads use the memory and the files of the process until
+    // they exit.
+    currentThread->WaitForUserThreads();
+
+    // Processes at the other end of its pipes must see them closed now,
+    // not when this thread is destroyed.
+    for (unsigned fid = 0; fid < Table<OpenFile*>::SIZE; fid++) {
+        PipeEnd *end = currentThread->GetPipeEnd(fid);
+        if (end != nullptr) {
+            currentThread->SetPipeEnd(fid, nullptr);
+            delete end;
+        }
+    }
+
+    // Wait for the asynchronous requests on files, which use the open
+    // files.  Those on pipes and the console end on their own, once the
+    // pipes are closed if need be.
+    if (currentThread->ioRing != nullptr) {
+        currentThread->ioRing->Release();
+        currentThread->ioRing = nullptr;
+    }
+
+    #ifdef DEMAND_LOADING
+    #ifdef SWAP
+    coreMapLock->Acquire();
+    #endif
+    currentThread->space->UnmapAll(nullptr);
+    #ifdef SWAP
+    coreMapLock->Release();
+    #endif
+    #endif
+
+    currentThread->Finish(status);
+}
 
 ///
 /// Run a user program.
@@ -108,6 +170,143 @@ StartProcess(void * voidargv)
                     // exits by doing the system call `Exit`.
 }
 
+///
+/// Run a process created by `Fork`, or a thread created by `ThreadCreate`.
+///
+/// It starts with the user registers given, which are a copy of those of
+/// its parent, taken when the parent made the system call, with a few
+/// changes.
+///
+
+static void
+StartForkedProcess(void * voidRegisters)
+{
+    int *registers = (int *)voidRegisters;
+
+    for (unsigned i = 0; i < NUM_TOTAL_REGS; i++)
+        machine->WriteRegister(i, registers[i]);
+    delete [] registers;
+
+    currentThread->space->RestoreState();   // Load page table register.
+
+    machine->Run();  // Jump to the user progam.
+    ASSERT(false);   // `machine->Run` never returns.
+}
+
+/// Return the file open as `fid` in the current process, or null if there
+/// is none.  The console and pipes have no `OpenFile`, so they get null
+/// too.
+static OpenFile *
+GetOpenFile(int fid)
+{
+    if(fid < 0 || !currentThread->GetOpenedFilesTable()->HasKey(fid)) {
+        return nullptr;
+    }
+    return currentThread->GetOpenedFilesTable()->Get(fid);
+}
+
+/// Read up to `size` bytes from `fid`, which may be the console, into
+/// `buffer`, and return how many were read, 0 in case of error.  The
+/// console hands out at most a line at a time.
+static int
+ReadFromFile(int fid, char *buffer, int size)
+{
+    PipeEnd *end = currentThread->GetPipeEnd(fid);
+    if(end != nullptr) {
+        if(end->IsWriting()) {
+            DEBUG('e', "Error in read: id %d is the write end of a pipe\n", fid);
+            return 0;
+        }
+        return end->GetPipe()->Read(buffer, size);
+    }
+
+    if(fid == CONSOLE_INPUT) {
+        DEBUG('e', "Reading console input...\n");
+        return consoleSys->ReadLine(buffer, size);
+    }
+
+    OpenFile *file = GetOpenFile(fid);
+    if(file == nullptr) {
+        DEBUG('e', "Error in read: Not an opened file\n");
+        return 0;
+    }
+
+    int bytesRead = file->Read(buffer, size);
+    DEBUG('e', "Read %d bytes of %d from file id %d\n", bytesRead, size, fid);
+    return bytesRead > 0 ? bytesRead : 0;
+}
+
+/// Write `size` bytes of `buffer` to `fid`, which may be the console, and
+/// return how many were written, 0 in case of error.
+static int
+WriteToFile(int fid, const char *buffer, int size)
+{
+    PipeEnd *end = currentThread->GetPipeEnd(fid);
+    if(end != nullptr) {
+        if(!end->IsWriting()) {
+            DEBUG('e', "Error in write: id %d is the read end of a pipe\n", fid);
+            return 0;
+        }
+        return end->GetPipe()->Write(buffer, size);
+    }
+
+    if(fid == CONSOLE_OUTPUT) {
+        consoleSys->Write(buffer, size);
+        return size;
+    }
+
+    OpenFile *file = GetOpenFile(fid);
+    if(file == nullptr) {
+        DEBUG('e', "Error in write: the file was not opened\n");
+        return 0;
+    }
+
+    int bytesWritten = file->Write(buffer, size);
+    DEBUG('e', "Wrote %d bytes of %d to file id %d\n", bytesWritten, size, fid);
+    return bytesWritten > 0 ? bytesWritten : 0;
+}
+
+/// Read the `count` entries of the user array of `IoVec` at `vectorAddr`
+/// into `addresses` and `sizes`, and return the sum of the sizes, or -1 if
+/// the array cannot be read, any entry is not valid or the sum is over
+/// `MAX_IO_SIZE`.
+static int
+ReadIoVector(int vectorAddr, int count, int *addresses, int *sizes)
+{
+    int *words = new int [2 * count];
+    if(!ReadBufferFromUser(vectorAddr, (char *) words, 8 * count)) {
+        delete [] words;
+        return -1;
+    }
+
+    int total = 0;
+    for(int i = 0; i < count; i++) {
+        addresses[i] = WordToHost(words[2 * i]);
+        sizes[i]     = WordToHost(words[2 * i + 1]);
+        if(sizes[i] < 0 || (sizes[i] > 0 && addresses[i] == 0)
+           || sizes[i] > MAX_IO_SIZE - total) {
+            total = -1;
+            break;
+        }
+        total += sizes[i];
+    }
+    delete [] words;
+    return total;
+}
+
+/// Check that `fid` can become the stream `console` of a new process: it is
+/// either `console` itself, or a pipe end of the current process that
+/// writes, if `writing`, or reads otherwise.  Store the pipe end, or null,
+/// in `end`.
+static bool
+GetStream(int fid, int console, bool writing, PipeEnd **end)
+{
+    *end = currentThread->GetPipeEnd(fid);
+    if(*end != nullptr)
+        return (*end)->IsWriting() == writing;
+    return fid == console;
+}
+
 
 /// Handle a system call exception.
 ///
@@ -129,6 +328,12 @@ static void
 SyscallHandler(ExceptionType _et)
 {
     int scid = machine->ReadRegister(2);
+    unsigned long startTicks = stats->totalTicks;
+
+    // `Exit` and `Halt` never come back here.
+    if (syscallStats != nullptr && (scid == SC_EXIT || scid == SC_HALT)) {
+        syscallStats->RecordNoReturn(scid);
+    }
 
     switch (scid) {
 
@@ -145,15 +350,17 @@ SyscallHandler(ExceptionType _et)
 
             DEBUG('e', "The program finished with status %d.\n", status);
 
-            currentThread->Finish(status);
+            ExitProcess(status);
 
             break;
         }
 
-        case SC_EXEC: {
+        case SC_EXEC:
+        case SC_EXECREDIRECT: {
             int processAddr = machine->ReadRegister(4);
             int argvAddr = machine->ReadRegister(5);
             bool isJoinable = (bool)machine->ReadRegister(6);
+            int streamsAddr = scid == SC_EXECREDIRECT ? machine->ReadRegister(7) : 0;
             char** argv = nullptr;
 
             if (processAddr == 0) {
@@ -162,10 +369,27 @@ SyscallHandler(ExceptionType _et)
                 break;
             }
 
+            PipeEnd *streams[2] = { nullptr, nullptr };
+            if (streamsAddr != 0) {
+                int ids[2];
+                if (!ReadBufferFromUser(streamsAddr, (char *) ids, sizeof ids)) {
+                    DEBUG('e', "Error in ExecRedirect: bad address of the streams.\n");
+                    machine->WriteRegister(2, -1);
+                    break;
+                }
+                if (!GetStream(WordToHost(ids[0]), CONSOLE_INPUT, false, &streams[0])
+                      || !GetStream(WordToHost(ids[1]), CONSOLE_OUTPUT, true, &streams[1])) {
+                    DEBUG('e', "Error in ExecRedirect: invalid streams %d and %d.\n",
+                          WordToHost(ids[0]), WordToHost(ids[1]));
+                    machine->WriteRegister(2, -1);
+                    break;
+                }
+            }
+
             char* filename = new char[FILE_NAME_MAX_LEN + 1];
 
             if (! ReadStringFromUser(processAddr, filename, FILE_NAME_MAX_LEN + 1)) {
-                DEBUG('e', "Error: filename string too long (maximum is %u bytes).\n",
+                DEBUG('e', "Error: bad filename string, or too long (maximum is %u bytes).\n",
                       FILE_NAME_MAX_LEN);
                 delete [] filename;
                 machine->WriteRegister(2, -1);
@@ -175,6 +399,12 @@ SyscallHandler(ExceptionType _et)
             if (argvAddr) {
                 DEBUG('e', "argvAddr distinto de cero, con direccion: %d\n", argvAddr);
                 argv = SaveArgs(argvAddr);
+                if (argv == nullptr) {
+                    DEBUG('e', "Error in Exec: bad arguments.\n");
+                    delete [] filename;
+                    machine->WriteRegister(2, -1);
+                    break;
+                }
             }
 
             DEBUG('e', "el nombre del archivo a abrir es %s y direccion de memoria %p\n", filename, filename);
@@ -203,6 +433,12 @@ SyscallHandler(ExceptionType _et)
 
             newThread->space = space;
 
+            // The new process gets its own ends of the pipes.
+            if (streams[0] != nullptr)
+                newThread->SetPipeEnd(CONSOLE_INPUT, new PipeEnd(streams[0]->GetPipe(), false));
+            if (streams[1] != nullptr)
+                newThread->SetPipeEnd(CONSOLE_OUTPUT, new PipeEnd(streams[1]->GetPipe(), true));
+
             #ifndef DEMAND_LOADING
             DEBUG('e', "Deleting executable...\n");
             delete executable;
@@ -234,6 +470,129 @@ SyscallHandler(ExceptionType _et)
             break;
         }
 
+        case SC_FORK: {
+            bool isJoinable = (bool)machine->ReadRegister(4);
+
+            Thread *newThread = new Thread(currentThread->GetName(), isJoinable,
+                                           currentThread->GetPriority());
+            SpaceId spaceId = (SpaceId)newThread->GetSpaceId();
+
+            DEBUG('e', "Forking process %d into %d\n", currentThread->GetSpaceId(), spaceId);
+
+            #ifdef SWAP
+            coreMapLock->Acquire();
+            #endif
+            newThread->space = new AddressSpace(currentThread->space, spaceId);
+            #ifdef SWAP
+            coreMapLock->Release();
+            #endif
+
+            // The child goes on right after the system call, and gets 0 as
+            // the result.
+            int *registers = new int[NUM_TOTAL_REGS];
+            for (unsigned i = 0; i < NUM_TOTAL_REGS; i++)
+                registers[i] = machine->ReadRegister(i);
+            registers[2] = 0;
+            registers[PREV_PC_REG] = registers[PC_REG];
+            registers[PC_REG] = registers[NEXT_PC_REG];
+            registers[NEXT_PC_REG] += 4;
+
+            newThread->Fork(StartForkedProcess, (void *) registers);
+
+            machine->WriteRegister(2, spaceId);
+
+            break;
+        }
+
+        case SC_THREADCREATE: {
+            int funcAddr = machine->ReadRegister(4);
+            int arg = machine->ReadRegister(5);
+            bool isJoinable = (bool)machine->ReadRegister(6);
+            int startAddr = machine->ReadRegister(7);  // Set by the stub.
+
+            if (funcAddr == 0) {
+                DEBUG('e', "Error in ThreadCreate: function address is null.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            int stack = currentThread->space->TakeThreadStack();
+            if (stack == -1) {
+                DEBUG('e', "Error in ThreadCreate: process %d has too many threads.\n",
+                      currentThread->GetProcess()->GetSpaceId());
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            Thread *newThread = new Thread(currentThread->GetName(), isJoinable,
+                                           currentThread->GetPriority());
+            newThread->SetProcess(currentThread->GetProcess());
+            newThread->userStack = stack;
+            SpaceId threadId = (SpaceId)newThread->GetSpaceId();
+
+            DEBUG('e', "Thread %d of process %d starts with stack at %d\n",
+                  threadId, currentThread->GetProcess()->GetSpaceId(), stack);
+
+            // The stub of `ThreadCreate` passes where the thread starts: a
+            // routine that calls the function, with its argument, and then
+            // `Exit`.
+            int *registers = new int[NUM_TOTAL_REGS];
+            for (unsigned i = 0; i < NUM_TOTAL_REGS; i++)
+                registers[i] = machine->ReadRegister(i);
+            registers[4] = funcAddr;
+            registers[5] = arg;
+            registers[STACK_REG] = stack;
+            registers[RET_ADDR_REG] = 0;
+            registers[PREV_PC_REG] = startAddr;
+            registers[PC_REG] = startAddr;
+            registers[NEXT_PC_REG] = startAddr + 4;
+
+            newThread->Fork(StartForkedProcess, (void *) registers);
+
+            machine->WriteRegister(2, threadId);
+
+            break;
+        }
+
+        case SC_YIELD: {
+            currentThread->Yield();
+
+            break;
+        }
+
+        case SC_FUTEXWAIT: {
+            int address = machine->ReadRegister(4);
+            int value = machine->ReadRegister(5);
+
+            if (address == 0 || address % 4 != 0) {
+                DEBUG('e', "Error in FutexWait: bad address %d.\n", address);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            bool slept = futexes->Wait(currentThread->space, address, value);
+            machine->WriteRegister(2, slept ? 0 : -1);
+
+            break;
+        }
+
+        case SC_FUTEXWAKE: {
+            int address = machine->ReadRegister(4);
+            int count = machine->ReadRegister(5);
+
+            if (address == 0 || address % 4 != 0 || count < 0) {
+                DEBUG('e', "Error in FutexWake: bad address %d or count %d.\n",
+                      address, count);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            unsigned woken = futexes->Wake(currentThread->space, address, count);
+            machine->WriteRegister(2, woken);
+
+            break;
+        }
+
         case SC_CREATE: {
             int filenameAddr = machine->ReadRegister(4);
             bool isDirectory = machine->ReadRegister(5);
@@ -247,7 +606,7 @@ SyscallHandler(ExceptionType _et)
             char* filename = new char[FILE_PATH_MAX_LEN + 1];
             if (!ReadStringFromUser(filenameAddr,
                                     filename, FILE_PATH_MAX_LEN + 1)) {
-                DEBUG('e', "Error: filename string too long (maximum is %u bytes).\n",
+                DEBUG('e', "Error: bad filename string, or too long (maximum is %u bytes).\n",
                       FILE_PATH_MAX_LEN);
                 machine->WriteRegister(2, 1);
                 break;
@@ -287,7 +646,7 @@ SyscallHandler(ExceptionType _et)
             char* filename = new char[FILE_NAME_MAX_LEN + 1];
             if (!ReadStringFromUser(filenameAddr,
                                     filename, FILE_NAME_MAX_LEN + 1)) {
-                DEBUG('e', "Error: filename string too long (maximum is %u bytes).\n",
+                DEBUG('e', "Error: bad filename string, or too long (maximum is %u bytes).\n",
                       FILE_NAME_MAX_LEN);
                 machine->WriteRegister(2, 1);
                 break;
@@ -332,7 +691,7 @@ SyscallHandler(ExceptionType _et)
             char* filename = new char[FILE_NAME_MAX_LEN + 1];
 
             if (!ReadStringFromUser(filenameAddr, filename, FILE_NAME_MAX_LEN + 1)) {
-                DEBUG('e', "Error: filename string too long (maximum is %u bytes).\n",
+                DEBUG('e', "Error: bad filename string, or too long (maximum is %u bytes).\n",
                     FILE_NAME_MAX_LEN);
                 machine->WriteRegister(2, -1);
                 break;
@@ -363,7 +722,32 @@ SyscallHandler(ExceptionType _et)
             int fid = machine->ReadRegister(4);
             DEBUG('e', "`Close` requested for id %u.\n", fid);
 
+            PipeEnd *end = currentThread->GetPipeEnd(fid);
+            if(end != nullptr && fid != CONSOLE_INPUT && fid != CONSOLE_OUTPUT) {
+                // Asynchronous requests on the pipe hold it open on their own.
+                currentThread->SetPipeEnd(fid, nullptr);
+                currentThread->GetOpenedFilesTable()->Remove(fid);
+                delete end;
+
+                DEBUG('e', "Pipe end closed successfully!\n");
+                machine->WriteRegister(2, 0);
+                break;
+            }
+
             if(currentThread->GetOpenedFilesTable()->HasKey(fid) && fid != 0 && fid != 1) {
+                if(currentThread->ioRing != nullptr)
+                    currentThread->ioRing->Drain(fid);  // It may have requests on the file.
+
+                #ifdef DEMAND_LOADING
+                #ifdef SWAP
+                coreMapLock->Acquire();
+                #endif
+                currentThread->space->UnmapAll(currentThread->GetOpenedFilesTable()->Get(fid));
+                #ifdef SWAP
+                coreMapLock->Release();
+                #endif
+                #endif
+
                 #ifdef FILESYS
                 currentThread->GetOpenedFilesTable()->Get(fid)->Close();
                 #endif
@@ -396,109 +780,357 @@ SyscallHandler(ExceptionType _et)
                 machine->WriteRegister(2, 0);
                 break;
             }
-            if(fid < 0){
-                DEBUG('e', "Invalid file descriptor ID to Read\n");    //to avoid the assert in Remove function
+            if (nbytes > MAX_IO_SIZE)
+                nbytes = MAX_IO_SIZE;
+
+            char* buffer = new char[nbytes];
+
+            int bytesRead = ReadFromFile(fid, buffer, nbytes);
+            if(bytesRead > 0 && !WriteBufferToUser(buffer, usrStringAddr, bytesRead)) {
+                DEBUG('e', "Error in Read: bad buffer address.\n");
+                bytesRead = -1;
+            }
+            machine->WriteRegister(2, bytesRead);
+
+            delete [] buffer;
+
+            break;
+        }
+
+        case SC_WRITE: {
+            int usrStringAddr = machine->ReadRegister(4);
+            int nbytes = machine->ReadRegister(5);
+            int fid = machine->ReadRegister(6);
+
+            if (usrStringAddr == 0) {
+                DEBUG('e', "Error in Write: address string is null.\n");
                 machine->WriteRegister(2, 0);
                 break;
             }
+            if (nbytes <= 0){
+                DEBUG('e', "Error in Write: invalid number of bytes.\n");
+                machine->WriteRegister(2, 0);
+                break;
+            }
+            if (nbytes > MAX_IO_SIZE)
+                nbytes = MAX_IO_SIZE;
 
-            char* buffer = new char[nbytes + 1];
+            char* buffer = new char[nbytes];
+            if(!ReadBufferFromUser(usrStringAddr, buffer, nbytes)) {
+                DEBUG('e', "Error in Write: bad buffer address.\n");
+                machine->WriteRegister(2, -1);
+                delete [] buffer;
+                break;
+            }
 
-            if(fid == CONSOLE_INPUT) {
-                DEBUG('e', "Reading console input...\n");
+            machine->WriteRegister(2, WriteToFile(fid, buffer, nbytes));
 
-                for(int i = 0; i < nbytes; i++)
-                    buffer[i] = consoleSys->ReadConsole();
+            delete [] buffer;
 
-                WriteBufferToUser(buffer, usrStringAddr, nbytes);
-                machine->WriteRegister(2, nbytes);
-            } else if(!currentThread->GetOpenedFilesTable()->HasKey(fid)) {
-                DEBUG('e', "Error in read: Not an opened file\n");
-                machine->WriteRegister(2, 0);
-            } else {
-                OpenFile* file = currentThread->GetOpenedFilesTable()->Get(fid);
+            break;
+        }
 
-                int bytesRead = file->Read(buffer, nbytes);
+        case SC_COPYFILE: {
+            int fromFid = machine->ReadRegister(4);
+            int toFid = machine->ReadRegister(5);
+            int length = machine->ReadRegister(6);
 
-                DEBUG('e', "Read: %s, nrobytes: %d de %d, fromfileid: %d, fileaddr: %p\n", buffer, bytesRead, nbytes, fid, file);
+            DEBUG('e', "`CopyFile` requested for %d bytes from id %d to id %d.\n",
+                  length, fromFid, toFid);
 
-                if(bytesRead <= 0) {
-                    DEBUG('e', "error in read: wrong bytes read\n");
-                    machine->WriteRegister(2, 0);
-                } else {
-                    WriteBufferToUser(buffer, usrStringAddr, nbytes);
-                    machine->WriteRegister(2, bytesRead);
-                }
+            if(length <= 0) {
+                DEBUG('e', "Error in CopyFile: invalid number of bytes.\n");
+                machine->WriteRegister(2, -1);
+                break;
             }
 
+            // The data goes through a kernel buffer, a few sectors at a
+            // time.  Copying from a file, the first chunk ends at a sector
+            // boundary, so that every following read takes whole sectors.
+            OpenFile *from = GetOpenFile(fromFid);
+            char *buffer = new char[COPY_CHUNK_SIZE];
+            int copied = 0;
+            while(copied < length) {
+                int chunk = COPY_CHUNK_SIZE;
+                if(copied == 0 && from != nullptr)
+                    chunk -= from->Tell() % SECTOR_SIZE;
+                if(chunk > length - copied)
+                    chunk = length - copied;
+
+                int bytesRead = ReadFromFile(fromFid, buffer, chunk);
+                int bytesWritten = bytesRead > 0 ? WriteToFile(toFid, buffer, bytesRead) : 0;
+                copied += bytesWritten;
+                // A short read is the end of a file, or all the console or a
+                // pipe had for now.
+                if(bytesRead < chunk || bytesWritten < bytesRead)
+                    break;
+            }
             delete [] buffer;
 
+            DEBUG('e', "Copied %d bytes from id %d to id %d.\n", copied, fromFid, toFid);
+            machine->WriteRegister(2, copied);
             break;
         }
 
-        case SC_WRITE: {
+        case SC_SEEK: {
+            int fid = machine->ReadRegister(4);
+            int offset = machine->ReadRegister(5);
+            int whence = machine->ReadRegister(6);
+
+            DEBUG('e', "`Seek` requested for id %d, offset %d, whence %d.\n",
+                  fid, offset, whence);
+
+            OpenFile *file = GetOpenFile(fid);
+            if(file == nullptr) {
+                DEBUG('e', "Error in Seek: not an opened file.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            long base;
+            if(whence == SEEK_FROM_START)
+                base = 0;
+            else if(whence == SEEK_FROM_CURRENT)
+                base = file->Tell();
+            else if(whence == SEEK_FROM_END)
+                base = file->Length();
+            else {
+                DEBUG('e', "Error in Seek: invalid whence.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            long position = base + offset;
+            if(position < 0 || position > (long) file->Length()) {
+                DEBUG('e', "Error in Seek: position %ld out of the file.\n", position);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            file->Seek(position);
+            machine->WriteRegister(2, position);
+
+            break;
+        }
+
+        case SC_PREAD:
+        case SC_PWRITE: {
             int usrStringAddr = machine->ReadRegister(4);
             int nbytes = machine->ReadRegister(5);
             int fid = machine->ReadRegister(6);
+            int position = machine->ReadRegister(7);
+            bool writing = scid == SC_PWRITE;
 
+            DEBUG('e', "`%s` requested for id %d, %d bytes at %d.\n",
+                  writing ? "PWrite" : "PRead", fid, nbytes, position);
 
-            if (usrStringAddr == 0) {
-                DEBUG('e', "Error in Write: address string is null.\n");
+            OpenFile *file = GetOpenFile(fid);
+            if(usrStringAddr == 0 || nbytes <= 0 || position < 0 || file == nullptr) {
+                DEBUG('e', "Error in positional I/O: invalid arguments.\n");
                 machine->WriteRegister(2, 0);
                 break;
             }
-            if (nbytes <= 0){
-                DEBUG('e', "Error in Write: invalid number of bytes.\n");
+            if(writing && (unsigned) position > file->Length()) {
+                DEBUG('e', "Error in PWrite: position past the end of the file.\n");
                 machine->WriteRegister(2, 0);
                 break;
             }
-            if(fid < 0){
-                DEBUG('e', "Invalid file descriptor ID to Write\n");    //to avoid the assert in Remove function
-                machine->WriteRegister(2, 0);
+            if(nbytes > MAX_IO_SIZE)
+                nbytes = MAX_IO_SIZE;
+
+            char* buffer = new char[nbytes];
+            if(writing && !ReadBufferFromUser(usrStringAddr, buffer, nbytes)) {
+                DEBUG('e', "Error in PWrite: bad buffer address.\n");
+                machine->WriteRegister(2, -1);
+                delete [] buffer;
                 break;
             }
 
-            char* buffer = new char[nbytes + 1];
-            ReadBufferFromUser(usrStringAddr, buffer, nbytes);
+            // The position of the open file is not used, so that requests
+            // of an I/O ring can go on with the file meanwhile.
+            int result = writing ? file->WriteAt(buffer, nbytes, position)
+                                 : file->ReadAt(buffer, nbytes, position);
 
-            if(fid == CONSOLE_OUTPUT) {
-                for(int i = 0; i < nbytes; i++)
-                    consoleSys->WriteConsole(buffer[i]);
+            if(result < 0)
+                result = 0;
+            if(!writing && result > 0 && !WriteBufferToUser(buffer, usrStringAddr, result)) {
+                DEBUG('e', "Error in PRead: bad buffer address.\n");
+                result = -1;
+            }
+            machine->WriteRegister(2, result);
 
-                machine->WriteRegister(2, nbytes);
-            } else if(!currentThread->GetOpenedFilesTable()->HasKey(fid)) {
-                DEBUG('e', "Error in write: the file was not opened\n");
-                machine->WriteRegister(2, 0);
-            } else {
+            delete [] buffer;
+
+            break;
+        }
 
-                OpenFile* file = currentThread->GetOpenedFilesTable()->Get(fid);
+        case SC_READV:
+        case SC_WRITEV: {
+            int vectorAddr = machine->ReadRegister(4);
+            int count = machine->ReadRegister(5);
+            int fid = machine->ReadRegister(6);
+            bool writing = scid == SC_WRITEV;
 
-                int bytesWrited = file->Write(buffer, nbytes);
+            DEBUG('e', "`%s` requested for id %d, %d buffers.\n",
+                  writing ? "WriteV" : "ReadV", fid, count);
 
-                if(bytesWrited <= 0) {
-                    DEBUG('e', "error in write: wrong bytes writed");
-                    machine->WriteRegister(2, 0);
-                } else {
-                    machine->WriteRegister(2, bytesWrited);
-                    DEBUG('e', "SUCESS! %d writed \n", bytesWrited);
+            if(vectorAddr == 0 || count <= 0 || count > MAX_IOVEC) {
+                DEBUG('e', "Error in vectored I/O: invalid vector.\n");
+                machine->WriteRegister(2, 0);
+                break;
+            }
+
+            int addresses[MAX_IOVEC], sizes[MAX_IOVEC];
+            int total = ReadIoVector(vectorAddr, count, addresses, sizes);
+            if(total <= 0) {
+                DEBUG('e', "Error in vectored I/O: invalid buffers.\n");
+                machine->WriteRegister(2, total);
+                break;
+            }
+
+            // The buffers are gathered into, or scattered from, a single
+            // one, so that the file is accessed once.
+            char* buffer = new char[total];
+            int result;
+            if(writing) {
+                bool gathered = true;
+                for(int i = 0, offset = 0; gathered && i < count; offset += sizes[i++])
+                    if(sizes[i] > 0)
+                        gathered = ReadBufferFromUser(addresses[i], &buffer[offset], sizes[i]);
+                result = gathered ? WriteToFile(fid, buffer, total) : -1;
+            } else {
+                result = ReadFromFile(fid, buffer, total);
+                for(int i = 0, offset = 0; i < count && offset < result; offset += sizes[i++]) {
+                    int chunk = result - offset < sizes[i] ? result - offset : sizes[i];
+                    if(chunk > 0 && !WriteBufferToUser(&buffer[offset], addresses[i], chunk))
+                        result = -1;
                 }
             }
+            if(result < 0)
+                DEBUG('e', "Error in vectored I/O: bad buffer address.\n");
+            machine->WriteRegister(2, result);
 
             delete [] buffer;
 
             break;
         }
 
+        case SC_PIPE: {
+            int endsAddr = machine->ReadRegister(4);
+
+            DEBUG('e', "`Pipe` requested.\n");
+
+            if(endsAddr == 0) {
+                DEBUG('e', "Error in Pipe: address of the ids is null.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            // Pipe ends take ids with no file in the table, like the console.
+            Table<OpenFile*> *files = currentThread->GetOpenedFilesTable();
+            int readId = files->Add(nullptr);
+            int writeId = readId < 0 ? -1 : files->Add(nullptr);
+            if(writeId < 0) {
+                if(readId >= 0)
+                    files->Remove(readId);
+                DEBUG('e', "Error in Pipe: too many open files.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            int ids[2] = { (int) WordToMachine(readId), (int) WordToMachine(writeId) };
+            if(!WriteBufferToUser((const char *) ids, endsAddr, sizeof ids)) {
+                files->Remove(readId);
+                files->Remove(writeId);
+                DEBUG('e', "Error in Pipe: bad address of the ids.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            PipeBuffer *pipe = new PipeBuffer;
+            currentThread->SetPipeEnd(readId, new PipeEnd(pipe, false));
+            currentThread->SetPipeEnd(writeId, new PipeEnd(pipe, true));
+
+            DEBUG('e', "Pipe created with ids %d and %d.\n", readId, writeId);
+            machine->WriteRegister(2, 0);
+            break;
+        }
+
+        case SC_IOSETUP: {
+            int ringAddr = machine->ReadRegister(4);
+            int entries = machine->ReadRegister(5);
+
+            DEBUG('e', "`IoSetup` requested at %d, %d entries.\n", ringAddr, entries);
+
+            if(ringAddr == 0 || ringAddr % 4 != 0 || entries <= 0
+                 || entries > IO_RING_MAX_ENTRIES || (entries & (entries - 1)) != 0) {
+                DEBUG('e', "Error in IoSetup: invalid ring.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+            if(currentThread->ioRing != nullptr && !currentThread->ioRing->IsIdle()) {
+                DEBUG('e', "Error in IoSetup: the current ring is busy.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            IoRing *ring = new IoRing(ringAddr, entries);
+            if(!ring->Reset()) {
+                ring->Release();
+                DEBUG('e', "Error in IoSetup: bad address of the ring.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+            if(currentThread->ioRing != nullptr)
+                currentThread->ioRing->Release();
+            currentThread->ioRing = ring;
+            machine->WriteRegister(2, 0);
+
+            break;
+        }
+
+        case SC_IOENTER: {
+            int toSubmit = machine->ReadRegister(4);
+            int minComplete = machine->ReadRegister(5);
+            IoRing *ring = currentThread->ioRing;
+
+            DEBUG('e', "`IoEnter` requested: submit %d, wait for %d.\n",
+                  toSubmit, minComplete);
+
+            if(ring == nullptr || toSubmit < 0 || minComplete < 0) {
+                DEBUG('e', "Error in IoEnter: no ring, or invalid counts.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            int submitted = ring->Submit(toSubmit);
+            unsigned wanted = (unsigned) minComplete < ring->GetEntries()
+                              ? minComplete : ring->GetEntries();
+            if(submitted < 0 || !ring->Complete(wanted)) {
+                DEBUG('e', "Error in IoEnter: bad address of the ring.\n");
+                submitted = -1;
+            }
+            machine->WriteRegister(2, submitted);
+
+            break;
+        }
+
         case SC_LSDIR: {
 
             DEBUG('e', "`Ls` requested.\n");
             #ifdef FILESYS
             int usrStringAddr = machine->ReadRegister(4);
+            if (usrStringAddr == 0) {
+                DEBUG('e', "Error in Ls: address of the buffer is null.\n");
+                break;
+            }
             char* lsResult = new char[LSDIR_OUTPUT];
+            lsResult[0] = '\0';  // In case the directory is empty.
             unsigned bytesRead = fileSystem->Ls(lsResult);
 
-            if(bytesRead)
-                WriteBufferToUser(lsResult, usrStringAddr, LSDIR_OUTPUT);
+            // Only the names listed, and their terminating null.
+            if (!WriteBufferToUser(lsResult, usrStringAddr, bytesRead + 1))
+                DEBUG('e', "Error in Ls: bad buffer address.\n");
 
             delete [] lsResult;
             #endif
@@ -521,7 +1153,7 @@ SyscallHandler(ExceptionType _et)
             char* dirname = new char[FILE_PATH_MAX_LEN + 1];
 
             if (!ReadStringFromUser(dirNameAddr, dirname, FILE_PATH_MAX_LEN + 1)) {
-                DEBUG('e', "Error: filename string too long (maximum is %u bytes).\n",
+                DEBUG('e', "Error: bad filename string, or too long (maximum is %u bytes).\n",
                     FILE_PATH_MAX_LEN);
                 delete [] dirname;
                 machine->WriteRegister(2, 1);
@@ -544,12 +1176,243 @@ SyscallHandler(ExceptionType _et)
             break;
         }
 
+        case SC_MMAP: {
+            int fid = machine->ReadRegister(4);
+            int length = machine->ReadRegister(5);
+
+            DEBUG('e', "`Mmap` requested for id %d, length %d.\n", fid, length);
+
+            #ifdef DEMAND_LOADING
+            if(GetOpenFile(fid) == nullptr) {
+                DEBUG('e', "Error in Mmap: not an opened file.\n");
+                machine->WriteRegister(2, 0);
+                break;
+            }
+            if(length < 0) {
+                DEBUG('e', "Error in Mmap: invalid length.\n");
+                machine->WriteRegister(2, 0);
+                break;
+            }
+
+            OpenFile *file = currentThread->GetOpenedFilesTable()->Get(fid);
+            unsigned size = length > 0 ? (unsigned) length : file->Length();
+            if(size == 0) {
+                DEBUG('e', "Error in Mmap: the file is empty.\n");
+                machine->WriteRegister(2, 0);
+                break;
+            }
+
+            #ifdef SWAP
+            coreMapLock->Acquire();
+            #endif
+            int address = currentThread->space->MapFile(file, size);
+            #ifdef SWAP
+            coreMapLock->Release();
+            #endif
+
+            if(address == -1) {
+                DEBUG('e', "Error in Mmap: too many mapped files.\n");
+                machine->WriteRegister(2, 0);
+                break;
+            }
+            machine->WriteRegister(2, address);
+            #else
+            DEBUG('e', "Error: Mmap needs demand loading.\n");
+            machine->WriteRegister(2, 0);
+            #endif
+
+            break;
+        }
+
+        case SC_MUNMAP: {
+            int address = machine->ReadRegister(4);
+
+            DEBUG('e', "`Munmap` requested for address %d.\n", address);
+
+            #ifdef DEMAND_LOADING
+            #ifdef SWAP
+            coreMapLock->Acquire();
+            #endif
+            bool unmapped = currentThread->space->UnmapFile(address);
+            #ifdef SWAP
+            coreMapLock->Release();
+            #endif
+
+            if(!unmapped) {
+                DEBUG('e', "Error in Munmap: no file mapped at %d.\n", address);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+            machine->WriteRegister(2, 0);
+            #else
+            machine->WriteRegister(2, -1);
+            #endif
+
+            break;
+        }
+
+        case SC_SHMCREATE: {
+            int size = machine->ReadRegister(4);
+
+            DEBUG('e', "`ShmCreate` requested for %d bytes.\n", size);
+
+            #ifdef SWAP
+            if(size <= 0 || DivRoundUp((unsigned) size, PAGE_SIZE) > MAX_SEGMENT_PAGES) {
+                DEBUG('e', "Error in ShmCreate: invalid size.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            SharedSegment *segment = new SharedSegment(DivRoundUp((unsigned) size, PAGE_SIZE));
+            int id = sharedSegments->Add(segment);
+            if(id == -1) {
+                DEBUG('e', "Error in ShmCreate: too many segments.\n");
+                delete segment;
+            }
+            machine->WriteRegister(2, id);
+            #else
+            DEBUG('e', "Error: shared memory needs swap.\n");
+            machine->WriteRegister(2, -1);
+            #endif
+
+            break;
+        }
+
+        case SC_SHMATTACH: {
+            int id = machine->ReadRegister(4);
+
+            DEBUG('e', "`ShmAttach` requested for segment %d.\n", id);
+
+            #ifdef SWAP
+            if(!sharedSegments->HasKey(id)) {
+                DEBUG('e', "Error in ShmAttach: no segment %d.\n", id);
+                machine->WriteRegister(2, 0);
+                break;
+            }
+
+            coreMapLock->Acquire();
+            int address = currentThread->space->AttachSegment(sharedSegments->Get(id));
+            coreMapLock->Release();
+
+            if(address == -1) {
+                DEBUG('e', "Error in ShmAttach: too many mappings.\n");
+                machine->WriteRegister(2, 0);
+                break;
+            }
+            machine->WriteRegister(2, address);
+            #else
+            machine->WriteRegister(2, 0);
+            #endif
+
+            break;
+        }
+
+        case SC_SHMDETACH: {
+            int address = machine->ReadRegister(4);
+
+            DEBUG('e', "`ShmDetach` requested for address %d.\n", address);
+
+            #ifdef SWAP
+            coreMapLock->Acquire();
+            bool detached = currentThread->space->DetachSegment(address);
+            coreMapLock->Release();
+
+            if(!detached) {
+                DEBUG('e', "Error in ShmDetach: no segment at %d.\n", address);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+            machine->WriteRegister(2, 0);
+            #else
+            machine->WriteRegister(2, -1);
+            #endif
+
+            break;
+        }
+
+        case SC_MSGSEND: {
+            int key = machine->ReadRegister(4);
+            int bufferAddr = machine->ReadRegister(5);
+            int size = machine->ReadRegister(6);
+
+            DEBUG('e', "`MsgSend` requested for %d bytes on queue %d.\n", size, key);
+
+            if(size < 0 || size > MSG_MAX_SIZE || (size > 0 && bufferAddr == 0)) {
+                DEBUG('e', "Error in MsgSend: invalid buffer.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            MessageQueue *queue = messageQueues->Open(key);
+            if(queue == nullptr) {
+                DEBUG('e', "Error in MsgSend: too many queues.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+            Message *message = MessageFromUser(bufferAddr, size);
+            if(message == nullptr) {
+                messageQueues->Close(queue);
+                DEBUG('e', "Error in MsgSend: bad buffer address.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+            queue->Send(message);
+            messageQueues->Close(queue);
+
+            machine->WriteRegister(2, 0);
+            break;
+        }
+
+        case SC_MSGRECV: {
+            int key = machine->ReadRegister(4);
+            int bufferAddr = machine->ReadRegister(5);
+            int size = machine->ReadRegister(6);
+
+            DEBUG('e', "`MsgRecv` requested for %d bytes on queue %d.\n", size, key);
+
+            if(size < 0 || (size > 0 && bufferAddr == 0)) {
+                DEBUG('e', "Error in MsgRecv: invalid buffer.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            MessageQueue *queue = messageQueues->Open(key);
+            if(queue == nullptr) {
+                DEBUG('e', "Error in MsgRecv: too many queues.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+            Message *message = queue->Receive();
+            messageQueues->Close(queue);
+
+            machine->WriteRegister(2, MessageToUser(message, bufferAddr, size));
+            break;
+        }
+
+        case SC_SBRK: {
+            int increment = machine->ReadRegister(4);
+
+            DEBUG('e', "`Sbrk` requested for %d bytes.\n", increment);
+
+            int oldBreak = currentThread->space->Sbrk(increment);
+            if(oldBreak == -1)
+                DEBUG('e', "Error in Sbrk: the heap cannot grow %d bytes.\n", increment);
+            machine->WriteRegister(2, oldBreak);
+
+            break;
+        }
+
         default:
             fprintf(stderr, "Unexpected system call: id %d.\n", scid);
             ASSERT(false);
 
     }
 
+    if (syscallStats != nullptr) {
+        syscallStats->Record(scid, stats->totalTicks - startTicks,
+                             machine->ReadRegister(2));
+    }
+
     IncrementPC();
 }
 
@@ -565,29 +1428,55 @@ static void TLBPageFaultHandler(ExceptionType exc) {
     DEBUG('a',"There was a page fault. Searching... vpnAdress: %d \n", vpnAddress);
 
     int vpn = vpnAddress / PAGE_SIZE;
+
+    #ifdef DEMAND_LOADING
+    if(!currentThread->space->IsValidPage(vpn)) {
+        fprintf(stderr, "Invalid access to address %d, ending the process.\n", vpnAddress);
+        ExitProcess(-1);
+    }
+    #endif
+
     DEBUG('a', "vpn: %d, numFaults: %lu ,indice de la TLB: %d \n", vpn, currentThread->numFaults, currentThread->numFaults % TLB_SIZE);
 
     TranslationEntry* pageTableEntry = currentThread->space->getPageTableEntry(vpn);
 
+    #ifdef SWAP
+    // Keep the page daemon away from the frame until the page is loaded and
+    // its translation is in the TLB.
+    coreMapLock->Acquire();
+    #endif
+
     #ifdef DEMAND_LOADING
 
     pageTableEntry->valid = true;
 
-    if(pageTableEntry->physicalPage == INT_MAX) {   // the page is not in main memory
+    if(pageTableEntry->physicalPage == INT_MAX   // the page is not in main memory
+    #ifdef SWAP
+         && !currentThread->space->MapSharedPage(vpn)  // nor is it shared
+    #endif
+      ) {
         DEBUG('a', "Loading page that does not exists in memory (demand loading)\n");
-        int possibleFrame = addressesBitMap->Find();
+        bool zeroed = false;
+        int possibleFrame = zeroDaemon->TakeFrame(currentThread->space->NeedsZeroFill(vpn), &zeroed);
         unsigned frame = (unsigned)possibleFrame;
         DEBUG('a',"frame to use: %u, possibleFrame: %d\n",frame, possibleFrame);
     #ifdef SWAP
         if(possibleFrame == -1) { //there aren't frames availables
             DEBUG('a', "I want to evacuate a page\n");
             DEBUG('a',"The page dirtyness is: %d\n", pageTableEntry->dirty);
-            frame = currentThread->space->EvacuatePage(); //cleans up a physical page and updates the coreMap,
-                                                             //returns the new physical page for use
-            possibleFrame = frame;
+            possibleFrame = currentThread->space->EvacuatePage(); //cleans up a physical page and updates the coreMap,
+                                                                     //returns the new physical page for use
+            frame = possibleFrame;
 
             DEBUG('a',"frame to use: %u, possibleFrame: %d\n",frame, possibleFrame);
-            ASSERT(possibleFrame != -1);
+            if(possibleFrame == -1) {
+                // The page to evict has to go to swap, and there is no
+                // room left there: this process cannot go on.
+                pageTableEntry->valid = false;
+                coreMapLock->Release();
+                fprintf(stderr, "Out of swap space, ending the process.\n");
+                ExitProcess(-1);
+            }
         }
     #endif
         pageTableEntry->physicalPage = frame;
@@ -596,8 +1485,16 @@ static void TLBPageFaultHandler(ExceptionType exc) {
         references_done++;
         coreMap[frame]->last_use_counter = references_done;
     #endif
+    #ifdef PRPOLICY_WSCLOCK
+        coreMap[frame]->last_use_tick = stats->totalTicks;
+    #endif
+
+        stats->numPageFaults++;
+        if(pageTrace != nullptr)
+            pageTrace->Record(currentThread->GetProcess()->GetSpaceId(), vpn, false, true);
 
-        currentThread->space->LoadPage(vpnAddress, pageTableEntry->physicalPage);
+        currentThread->space->LoadPage(vpnAddress, pageTableEntry->physicalPage, zeroed);
+        currentThread->space->Readahead(vpn);
     }
     #endif
 
@@ -614,10 +1511,58 @@ static void TLBPageFaultHandler(ExceptionType exc) {
     machine->GetMMU()->tlb[tlbEntry] = *pageTableEntry;
 
     currentThread->numFaults++;
+
+    #ifdef SWAP
+    if(addressesBitMap->CountClear() < pageDaemon->GetLowWatermark()) {
+        pageDaemon->Wake();
+    }
+    coreMapLock->Release();
+    #endif
     #endif
 
 }
 
+/// Handle a write to a read-only page.
+///
+/// Pages are only read-only while they are shared between processes, after
+/// a `Fork` or through the text cache: the writer gets its own copy, and the
+/// instruction is retried.
+static void
+ReadOnlyHandler(ExceptionType exc)
+{
+    #ifndef SWAP
+    DefaultHandler(exc);
+    #else
+    unsigned vpn = machine->ReadRegister(BAD_VADDR_REG) / PAGE_SIZE;
+
+    DEBUG('a', "Write to read-only page %u\n", vpn);
+
+    coreMapLock->Acquire();
+    if(!currentThread->space->CopyOnWrite(vpn)) {
+        coreMapLock->Release();
+        fprintf(stderr, "Out of swap space, ending the process.\n");
+        ExitProcess(-1);
+    }
+
+    // Refresh the cached translation, so that the retry does not fault
+    // again (the kernel only retries a user memory access a few times).
+    TranslationEntry *entry = currentThread->space->getPageTableEntry(vpn);
+    for(unsigned i = 0; i < TLB_SIZE; i++) {
+        TranslationEntry *cached = &machine->GetMMU()->tlb[i];
+        if(cached->valid && cached->virtualPage == vpn) {
+            entry->use = entry->use || cached->use;
+            if(entry->physicalPage == INT_MAX) {
+                cached->valid = false;
+            } else {
+                cached->physicalPage = entry->physicalPage;
+                cached->readOnly     = entry->readOnly;
+            }
+        }
+    }
+    coreMapLock->Release();
+    #endif
+}
+
 /// By default, only system calls have their own handler.  All other
 /// exception types are assigned the default handler.
 void
@@ -626,7 +1571,7 @@ SetExceptionHandlers()
     machine->SetHandler(NO_EXCEPTION,            &DefaultHandler);
     machine->SetHandler(SYSCALL_EXCEPTION,       &SyscallHandler);
     machine->SetHandler(PAGE_FAULT_EXCEPTION,    &TLBPageFaultHandler);
-    machine->SetHandler(READ_ONLY_EXCEPTION,     &DefaultHandler);
+    machine->SetHandler(READ_ONLY_EXCEPTION,     &ReadOnlyHandler);
     machine->SetHandler(BUS_ERROR_EXCEPTION,     &DefaultHandler);
     machine->SetHandler(ADDRESS_ERROR_EXCEPTION, &DefaultHandler);
     machine->SetHandler(OVERFLOW_EXCEPTION,      &DefaultHandler);
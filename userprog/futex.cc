@@ -0,0 +1,83 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "futex.hh"
+#include "transfer.hh"
+#include "machine/endianness.hh"
+#include "threads/system.hh"
+
+
+Futexes::Futexes()
+{
+    sleepers = new List<Sleeper *>;
+    lock     = new Lock("futexes");
+}
+
+Futexes::~Futexes()
+{
+    // Threads still sleeping at shutdown never run again.
+    while (!sleepers->IsEmpty()) {
+        sleepers->Pop();
+    }
+    delete sleepers;
+    delete lock;
+}
+
+bool
+Futexes::Wait(AddressSpace *space, int address, int value)
+{
+    ASSERT(space != nullptr);
+
+    lock->Acquire();
+
+    // Reading the word can fault, but wakers wait for the lock meanwhile.
+    int word;
+    if (!ReadBufferFromUser(address, (char *) &word, 4)
+          || (int) WordToHost(word) != value) {
+        lock->Release();
+        return false;
+    }
+
+    Sleeper sleeper;
+    sleeper.space   = space;
+    sleeper.address = address;
+    sleeper.woken   = new Semaphore("futex", 0);
+    sleepers->Append(&sleeper);
+    DEBUG('e', "Sleeping on futex at %d\n", address);
+    lock->Release();
+
+    // A wake-up between releasing the lock and here is kept by the
+    // semaphore.
+    sleeper.woken->P();
+    delete sleeper.woken;
+    return true;
+}
+
+unsigned
+Futexes::Wake(AddressSpace *space, int address, unsigned count)
+{
+    ASSERT(space != nullptr);
+
+    lock->Acquire();
+    List<Sleeper *> *others = new List<Sleeper *>;
+    unsigned woken = 0;
+    while (!sleepers->IsEmpty()) {
+        Sleeper *sleeper = sleepers->Pop();
+        if (woken < count && sleeper->space == space
+              && sleeper->address == address) {
+            sleeper->woken->V();
+            woken++;
+        } else {
+            others->Append(sleeper);
+        }
+    }
+    delete sleepers;
+    sleepers = others;
+    lock->Release();
+
+    DEBUG('e', "Woke %u of %u threads on futex at %d\n",
+          woken, count, address);
+    return woken;
+}
@@ -0,0 +1,60 @@
+/// Futexes: threads of a process sleeping on words of its memory (see
+/// `FutexWait` and `FutexWake` in `syscall.h`).
+///
+/// User code keeps its locks and conditions in plain words, and only enters
+/// the kernel to sleep when it has to wait, or to wake others up.  A thread
+/// goes to sleep only if the word still holds the value it saw, which is
+/// checked under the same lock that wakers take, so a wake-up that follows
+/// a change of the word cannot be missed.
+///
+/// Sleepers are found by address space and virtual address, so words in
+/// memory shared between processes do not work as futexes.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_FUTEX__HH
+#define NACHOS_USERPROG_FUTEX__HH
+
+
+#include "address_space.hh"
+#include "lib/list.hh"
+#include "threads/lock.hh"
+#include "threads/semaphore.hh"
+
+
+class Futexes {
+public:
+
+    Futexes();
+
+    ~Futexes();
+
+    /// If the word at `address` of `space` holds `value`, sleep until
+    /// `Wake` is called on it, and return true; otherwise, or if the word
+    /// cannot be read, return false right away.  `space` must be the
+    /// running address space.
+    bool Wait(AddressSpace *space, int address, int value);
+
+    /// Wake up to `count` threads sleeping on the word at `address` of
+    /// `space`, oldest first, and return how many were woken.
+    unsigned Wake(AddressSpace *space, int address, unsigned count);
+
+private:
+
+    /// A sleeping thread.
+    struct Sleeper {
+        AddressSpace *space;
+        int address;
+        Semaphore *woken;
+    };
+
+    /// Sleepers on every word, oldest first.
+    List<Sleeper *> *sleepers;
+
+    Lock *lock;
+};
+
+
+#endif
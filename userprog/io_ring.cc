@@ -0,0 +1,479 @@
+/// Routines for asynchronous I/O rings and their worker threads.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "io_ring.hh"
+#include "syscall.h"
+#include "transfer.hh"
+#include "machine/endianness.hh"
+#include "threads/system.hh"
+
+
+/// Layout of a ring in user memory, in bytes (see `syscall.h`).
+static const unsigned SUBMIT_HEAD_OFFSET   = 0;
+static const unsigned SUBMIT_TAIL_OFFSET   = 4;
+static const unsigned COMPLETE_HEAD_OFFSET = 8;
+static const unsigned COMPLETE_TAIL_OFFSET = 12;
+static const unsigned HEADER_SIZE          = 16;
+static const unsigned SUBMISSION_SIZE      = 24;
+static const unsigned COMPLETION_SIZE      = 8;
+
+
+IoRing::IoRing(int addressParam, unsigned entriesParam)
+{
+    ASSERT(addressParam != 0);
+    ASSERT(entriesParam > 0 && entriesParam <= IO_RING_MAX_ENTRIES);
+
+    address      = addressParam;
+    entries      = entriesParam;
+    submitHead   = 0;
+    completeTail = 0;
+    outstanding  = 0;
+    inFlight     = 0;
+    released     = false;
+    running  = new IoRequest * [entries];
+    for (unsigned i = 0; i < entries; i++) {
+        running[i] = nullptr;
+    }
+    lock     = new Lock("io ring");
+    done     = new Condition("io ring done", lock);
+    finished = new List<IoRequest *>;
+}
+
+IoRing::~IoRing()
+{
+    ASSERT(inFlight == 0);
+
+    while (!finished->IsEmpty()) {
+        IoRequest *request = finished->Pop();
+        delete [] request->buffer;
+        delete request;
+    }
+    delete finished;
+    delete [] running;
+    delete done;
+    delete lock;
+}
+
+void
+IoRing::Release()
+{
+    lock->Acquire();
+    while (Busy(-1)) {
+        done->Wait();
+    }
+    released = true;
+    bool last = inFlight == 0;
+    lock->Release();
+
+    if (last) {
+        delete this;
+    }
+}
+
+bool
+IoRing::Reset()
+{
+    char zeros[HEADER_SIZE] = {};
+    return WriteBufferToUser(zeros, address, HEADER_SIZE);
+}
+
+bool
+IoRing::ReadIndex(unsigned offset, unsigned *value)
+{
+    if (!ReadBufferFromUser(address + offset, (char *) value, 4)) {
+        return false;
+    }
+    *value = WordToHost(*value);
+    return true;
+}
+
+bool
+IoRing::WriteIndex(unsigned offset, unsigned value)
+{
+    value = WordToMachine(value);
+    return WriteBufferToUser((const char *) &value, address + offset, 4);
+}
+
+int
+IoRing::Submit(unsigned count)
+{
+    unsigned submitTail;
+    if (!ReadIndex(SUBMIT_TAIL_OFFSET, &submitTail)) {
+        return -1;
+    }
+    unsigned queued = submitTail - submitHead;
+    if (queued > entries) {
+        DEBUG('e', "Submission ring at %d is corrupt\n", address);
+        queued = 0;
+    }
+    if (count > queued) {
+        count = queued;
+    }
+    if (count > entries - outstanding) {
+        count = entries - outstanding;
+    }
+
+    for (unsigned i = 0; i < count; i++) {
+        int words[SUBMISSION_SIZE / 4];
+        if (!ReadBufferFromUser(address + HEADER_SIZE
+                                  + (submitHead % entries) * SUBMISSION_SIZE,
+                                (char *) words, SUBMISSION_SIZE)) {
+            return -1;
+        }
+        submitHead++;
+        outstanding++;
+
+        IoRequest *request = new IoRequest;
+        request->ring       = this;
+        request->opcode     = WordToHost(words[0]);
+        request->fid        = WordToHost(words[1]);
+        request->userBuffer = WordToHost(words[2]);
+        request->size       = WordToHost(words[3]);
+        request->position   = WordToHost(words[4]);
+        request->userData   = WordToHost(words[5]);
+        request->buffer     = nullptr;
+        request->file       = nullptr;
+        request->pipe       = nullptr;
+        request->result     = -1;
+
+        DEBUG('e', "Submitted I/O request %d: op %d, id %d, %d bytes at %d\n",
+              request->userData, request->opcode, request->fid,
+              request->size, request->position);
+
+        // Requests that can be answered right away go straight to the
+        // finished list.
+        bool valid = false;
+        if (request->opcode == IO_OP_NOP) {
+            request->result = 0;
+        } else if ((request->opcode == IO_OP_READ
+                      || request->opcode == IO_OP_WRITE)
+                   && request->userBuffer != 0 && request->size > 0
+                   && request->position >= -1) {
+            bool writing = request->opcode == IO_OP_WRITE;
+            PipeEnd *end = currentThread->GetPipeEnd(request->fid);
+            bool console = end == nullptr
+                             && request->fid == (writing ? CONSOLE_OUTPUT
+                                                         : CONSOLE_INPUT);
+            Table<OpenFile *> *files = currentThread->GetOpenedFilesTable();
+            if (end != nullptr) {
+                // Pipes have no position.
+                if (end->IsWriting() == writing && request->position == -1) {
+                    request->pipe = end->GetPipe();
+                    request->pipe->Open(writing);
+                }
+            } else if (!console && request->fid >= 0
+                         && files->HasKey(request->fid)) {
+                request->file = files->Get(request->fid);
+            }
+            valid = console || request->file != nullptr
+                      || request->pipe != nullptr;
+        }
+
+        if (valid) {
+            if (request->size > MAX_IO_SIZE) {
+                request->size = MAX_IO_SIZE;
+            }
+            request->buffer = new char [request->size];
+            if (request->opcode == IO_OP_WRITE
+                  && !ReadBufferFromUser(request->userBuffer, request->buffer,
+                                         request->size)) {
+                DEBUG('e', "I/O request %d has a bad buffer\n",
+                      request->userData);
+                if (request->pipe != nullptr && request->pipe->Close(true)) {
+                    delete request->pipe;
+                }
+                request->pipe = nullptr;
+                valid = false;
+            }
+        }
+
+        if (valid) {
+            lock->Acquire();
+            inFlight++;
+            unsigned slot = 0;
+            while (running[slot] != nullptr) {
+                slot++;
+            }
+            ASSERT(slot < entries);
+            running[slot] = request;
+            lock->Release();
+            ioWorkers->Queue(request);
+        } else {
+            lock->Acquire();
+            finished->Append(request);
+            lock->Release();
+        }
+    }
+
+    if (!WriteIndex(SUBMIT_HEAD_OFFSET, submitHead)) {
+        return -1;
+    }
+    return count;
+}
+
+int
+IoRing::Post()
+{
+    unsigned completeHead;
+    if (!ReadIndex(COMPLETE_HEAD_OFFSET, &completeHead)) {
+        return -1;
+    }
+    unsigned used = completeTail - completeHead;
+    if (used > entries) {
+        DEBUG('e', "Completion ring at %d is corrupt\n", address);
+        return 0;
+    }
+
+    bool posted = false;
+    for (; used < entries; used++) {
+        lock->Acquire();
+        IoRequest *request = finished->IsEmpty() ? nullptr : finished->Pop();
+        lock->Release();
+        if (request == nullptr) {
+            break;
+        }
+
+        if (request->opcode == IO_OP_READ && request->result > 0
+              && !WriteBufferToUser(request->buffer, request->userBuffer,
+                                    request->result)) {
+            DEBUG('e', "I/O request %d has a bad buffer\n",
+                  request->userData);
+            request->result = -1;
+        }
+        if (syscallStats != nullptr && request->result > 0) {
+            syscallStats->AddBytes(SC_IOENTER, request->result);
+        }
+        int completion[COMPLETION_SIZE / 4] = {
+            (int) WordToMachine(request->userData),
+            (int) WordToMachine(request->result)
+        };
+        bool written = WriteBufferToUser((const char *) completion,
+                         address + HEADER_SIZE + entries * SUBMISSION_SIZE
+                           + (completeTail % entries) * COMPLETION_SIZE,
+                         COMPLETION_SIZE);
+        outstanding--;
+        delete [] request->buffer;
+        delete request;
+        if (!written) {
+            return -1;  // The completion is lost.
+        }
+        completeTail++;
+        posted = true;
+    }
+
+    if (posted && !WriteIndex(COMPLETE_TAIL_OFFSET, completeTail)) {
+        return -1;
+    }
+    return used;
+}
+
+bool
+IoRing::Complete(unsigned minComplete)
+{
+    for (;;) {
+        int used = Post();
+        if (used < 0) {
+            return false;
+        }
+        if ((unsigned) used >= minComplete) {
+            return true;
+        }
+        lock->Acquire();
+        if (finished->IsEmpty() && inFlight == 0) {
+            lock->Release();
+            return true;  // Nothing else is coming.
+        }
+        if (finished->IsEmpty()) {
+            done->Wait();
+        }
+        lock->Release();
+    }
+}
+
+void
+IoRing::Drain(int fid)
+{
+    lock->Acquire();
+    while (Busy(fid)) {
+        done->Wait();
+    }
+    lock->Release();
+}
+
+bool
+IoRing::Busy(int fid) const
+{
+    for (unsigned i = 0; i < entries; i++) {
+        if (running[i] != nullptr && running[i]->file != nullptr
+              && (fid == -1 || running[i]->fid == fid)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+IoRing::IsIdle() const
+{
+    return outstanding == 0;
+}
+
+unsigned
+IoRing::GetEntries() const
+{
+    return entries;
+}
+
+void
+IoRing::Finish(IoRequest *request)
+{
+    lock->Acquire();
+    inFlight--;
+    for (unsigned i = 0; i < entries; i++) {
+        if (running[i] == request) {
+            running[i] = nullptr;
+        }
+    }
+
+    if (released) {
+        // Nobody is left to take the completion.
+        delete [] request->buffer;
+        delete request;
+        bool last = inFlight == 0;
+        lock->Release();
+        if (last) {
+            delete this;
+        }
+        return;
+    }
+
+    finished->Append(request);
+    done->Broadcast();
+    lock->Release();
+}
+
+
+static void
+IoWorkerHelper(void *arg)
+{
+    ((IoWorkers *) arg)->Run();
+}
+
+/// Body of the threads of requests that may wait for long.
+static void
+IoRequestHelper(void *arg)
+{
+    IoRequest *request = (IoRequest *) arg;
+    IoWorkers::Perform(request);
+    request->ring->Finish(request);
+}
+
+IoWorkers::IoWorkers()
+{
+    lock    = new Lock("io workers");
+    ready   = new Condition("io workers ready", lock);
+    queue   = new List<IoRequest *>;
+    started = false;
+}
+
+IoWorkers::~IoWorkers()
+{
+    delete queue;
+    delete ready;
+    delete lock;
+}
+
+void
+IoWorkers::Queue(IoRequest *request)
+{
+    ASSERT(request != nullptr);
+
+    if (request->pipe != nullptr
+          || (request->file == nullptr && request->opcode == IO_OP_READ)) {
+        Thread *t = new Thread("io request");
+        t->Fork(IoRequestHelper, request);
+        return;
+    }
+
+    if (!started) {
+        started = true;
+        for (unsigned i = 0; i < IO_WORKER_THREADS; i++) {
+            Thread *t = new Thread("io worker");
+            t->Fork(IoWorkerHelper, this);
+        }
+    }
+
+    lock->Acquire();
+    queue->Append(request);
+    ready->Signal();
+    lock->Release();
+}
+
+void
+IoWorkers::Run()
+{
+    for (;;) {
+        lock->Acquire();
+        while (queue->IsEmpty()) {
+            ready->Wait();
+        }
+        IoRequest *request = queue->Pop();
+        lock->Release();
+
+        Perform(request);
+        request->ring->Finish(request);
+    }
+}
+
+void
+IoWorkers::Perform(IoRequest *request)
+{
+    ASSERT(request != nullptr);
+
+    bool writing = request->opcode == IO_OP_WRITE;
+
+    if (request->pipe != nullptr) {
+        PipeBuffer *pipe = request->pipe;
+        request->result = writing ? pipe->Write(request->buffer, request->size)
+                                  : pipe->Read(request->buffer, request->size);
+        if (pipe->Close(writing)) {
+            delete pipe;
+        }
+        return;
+    }
+
+    if (request->file == nullptr) {
+        if (writing) {
+            consoleSys->Write(request->buffer, request->size);
+            request->result = request->size;
+        } else {
+            request->result = consoleSys->ReadLine(request->buffer,
+                                                   request->size);
+        }
+        return;
+    }
+
+    OpenFile *file = request->file;
+    if (request->position == -1) {
+        request->result = writing ? file->Write(request->buffer, request->size)
+                                  : file->Read(request->buffer, request->size);
+    } else if (writing && (unsigned) request->position > file->Length()) {
+        request->result = -1;  // Files cannot have holes.
+        return;
+    } else {
+        // The process may be using the position of the file meanwhile.
+        request->result = writing
+          ? file->WriteAt(request->buffer, request->size, request->position)
+          : file->ReadAt(request->buffer, request->size, request->position);
+    }
+    if (request->result < 0) {
+        request->result = -1;
+    }
+
+    DEBUG('e', "I/O request %d done: %d bytes\n",
+          request->userData, request->result);
+}
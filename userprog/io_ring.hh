@@ -0,0 +1,162 @@
+/// Asynchronous I/O for user programs, through submission and completion
+/// rings in their memory (see `IoSetup` and `IoEnter` in `syscall.h`).
+///
+/// Requests are carried out by a pool of kernel threads, so a process can
+/// keep computing, or issue more requests, while they wait for the disk or
+/// the console.  Requests on pipes and console reads may wait for another
+/// process, or for the user, for as long as it takes, so each one gets a
+/// kernel thread of its own instead, and cannot hold up the pool; there are
+/// at most as many of them as entries in the ring.  The worker threads
+/// never touch user memory: data to write is copied into the kernel when a
+/// request is submitted, and data read is copied out, along with the
+/// completion, the next time the process enters the kernel through
+/// `IoEnter`.  That way every access to user memory happens in the context
+/// of its own address space.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_IORING__HH
+#define NACHOS_USERPROG_IORING__HH
+
+
+#include "pipe.hh"
+#include "filesys/open_file.hh"
+#include "lib/list.hh"
+#include "threads/condition.hh"
+#include "threads/lock.hh"
+
+
+/// Number of kernel threads that carry out requests on files and console
+/// writes.
+const unsigned IO_WORKER_THREADS = 4;
+
+class IoRing;
+
+/// A request taken from a submission ring.
+struct IoRequest {
+    IoRing *ring;
+    int opcode;
+    int fid;
+    OpenFile *file;    ///< Null for the console and pipes.
+    PipeBuffer *pipe;  ///< Null for the console and files.  The request
+                       ///< counts as an end of its own, so the pipe
+                       ///< outlives the closing of the process's end.
+    char *buffer;      ///< Kernel copy of the data.
+    int size;
+    int position;
+    int userBuffer;
+    int userData;
+    int result;
+};
+
+/// The ring registered by a process.
+class IoRing {
+public:
+
+    /// Register the ring at user address `address`, with `entries` slots
+    /// for submissions and as many for completions.
+    IoRing(int address, unsigned entries);
+
+    /// Set the indices of the ring to 0.  Return false if they are not in
+    /// the memory of the process.
+    bool Reset();
+
+    /// Forget the ring.  Wait for the requests on files, which use the open
+    /// files of the process, and let those on pipes and the console end on
+    /// their own; the ring is deleted along with the last of them.
+    void Release();
+
+    /// Take up to `count` submissions from the ring and hand them to the
+    /// workers.  Return how many were taken, or -1 if the ring is not in
+    /// the memory of the process.  A request whose buffer is not there
+    /// completes with -1.
+    int Submit(unsigned count);
+
+    /// Write finished requests into the completion ring, waiting until it
+    /// holds at least `minComplete` completions, or nothing is pending.
+    /// Return false if the ring is not in the memory of the process.
+    bool Complete(unsigned minComplete);
+
+    /// Wait until no request on `fid` is in the hands of the workers.
+    void Drain(int fid);
+
+    /// Whether every request submitted was handed back as a completion.
+    bool IsIdle() const;
+
+    unsigned GetEntries() const;
+
+    /// Called by a worker once `request` is done.
+    void Finish(IoRequest *request);
+
+private:
+
+    /// Use `Release` instead.
+    ~IoRing();
+
+    /// Whether a request on a file is in flight, on `fid`, or on any file
+    /// if `fid` is -1.  The lock must be held.
+    bool Busy(int fid) const;
+
+    /// Write as many finished requests as fit into the completion ring, and
+    /// return how many completions it holds, or -1 if the ring is not in
+    /// the memory of the process.
+    int Post();
+
+    /// Read the word at `offset` of the ring header into `value`.  Return
+    /// false if it cannot be read.
+    bool ReadIndex(unsigned offset, unsigned *value);
+
+    /// Write `value` into the word at `offset` of the ring header.  Return
+    /// false if it cannot be written.
+    bool WriteIndex(unsigned offset, unsigned value);
+
+    int address;
+    unsigned entries;
+
+    /// Private copies of the indices the kernel owns.
+    unsigned submitHead;
+    unsigned completeTail;
+
+    /// Requests taken but not yet handed back as completions.
+    unsigned outstanding;
+
+    /// Protects what follows; workers signal `done` when they finish one.
+    Lock *lock;
+    Condition *done;
+    unsigned inFlight;
+    IoRequest **running;  ///< The requests in flight, in `entries` slots.
+    bool released;
+    List<IoRequest *> *finished;
+};
+
+/// The pool of worker threads, shared by every ring.  Threads are created
+/// along with the first request.
+class IoWorkers {
+public:
+
+    IoWorkers();
+
+    ~IoWorkers();
+
+    /// Queue `request` for the next free worker, or give it a thread of its
+    /// own if it may wait for long.
+    void Queue(IoRequest *request);
+
+    /// Body of the worker threads.  Never returns.
+    void Run();
+
+    /// Carry out `request`, and store its result.
+    static void Perform(IoRequest *request);
+
+private:
+
+    Lock *lock;
+    Condition *ready;
+    List<IoRequest *> *queue;
+    bool started;
+};
+
+
+#endif
@@ -0,0 +1,347 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "message_queue.hh"
+#include "transfer.hh"
+#include "threads/system.hh"
+
+#include <string.h>
+
+
+#ifdef SWAP
+/// Frames held by messages, or set aside for messages being built.
+static unsigned framesInTransit = 0;
+
+/// Take a free frame, or evict a page, for a page of a message that has to
+/// be copied.  Return -1 if no page can be evicted because the swap area is
+/// full.  `coreMapLock` must be held.
+static int
+TakeTransitFrame()
+{
+    int frame = zeroDaemon->TakeFrame(false, nullptr);
+    if (frame == -1) {
+        frame = AddressSpace::EvacuatePage();
+        if (frame == -1) {
+            return -1;
+        }
+    }
+    coreMap[frame]->inTransit = true;
+    if (addressesBitMap->CountClear() < pageDaemon->GetLowWatermark()) {
+        pageDaemon->Wake();
+    }
+    return frame;
+}
+
+/// Give back a frame of a message that was not mapped by the receiver.
+/// `coreMapLock` must be held.
+static void
+FreeTransitFrame(unsigned frame)
+{
+    ASSERT(coreMap[frame]->inTransit);
+
+    coreMap[frame]->inTransit = false;
+    framesInTransit--;
+    addressesBitMap->Clear(frame);
+}
+
+/// Whether the `numPages` pages from `userAddress` all belong to the
+/// current address space, so that moving them out of it cannot stop
+/// halfway.
+static bool
+IsUserRange(int userAddress, unsigned numPages)
+{
+    for (unsigned i = 0; i < numPages; i++) {
+        if (!currentThread->space->IsValidPage(userAddress / PAGE_SIZE + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+Message *
+MessageFromUser(int userAddress, unsigned size)
+{
+    Message *message = new Message;
+    message->size   = size;
+    message->data   = nullptr;
+    message->frames = nullptr;
+
+#ifdef SWAP
+    unsigned numPages = size / PAGE_SIZE;
+    if (size > 0 && userAddress % PAGE_SIZE == 0 && size % PAGE_SIZE == 0
+          && framesInTransit + numPages <= NUM_PHYS_PAGES / MSG_TRANSIT_FRACTION
+          && IsUserRange(userAddress, numPages)) {
+        framesInTransit += numPages;
+        message->frames = new unsigned [numPages];
+
+        char *mainMemory = machine->GetMMU()->mainMemory;
+        for (unsigned i = 0; i < numPages; i++) {
+            coreMapLock->Acquire();
+            int frame = currentThread->space->GiveAwayPage(
+                          userAddress / PAGE_SIZE + i);
+            bool moved = frame != -1;
+            if (moved) {
+                coreMap[frame]->inTransit = true;
+                stats->numMessagePagesRemapped++;
+            } else {
+                frame = TakeTransitFrame();
+            }
+            if (frame == -1) {
+                // Swap is full: keep the pages taken so far in a buffer
+                // instead, and copy the rest.
+                message->data = new char [size];
+                for (unsigned j = 0; j < i; j++) {
+                    memcpy(&message->data[j * PAGE_SIZE],
+                           &mainMemory[message->frames[j] * PAGE_SIZE],
+                           PAGE_SIZE);
+                    FreeTransitFrame(message->frames[j]);
+                }
+                framesInTransit -= numPages - i;
+                delete [] message->frames;
+                message->frames = nullptr;
+                coreMapLock->Release();
+
+                ReadBufferFromUser(userAddress + i * PAGE_SIZE,
+                                   &message->data[i * PAGE_SIZE],
+                                   size - i * PAGE_SIZE);
+                stats->numMessageBytesCopied += size;
+                return message;
+            }
+            coreMapLock->Release();
+
+            // Pages that are not in memory, or that other processes map as
+            // well, are copied; reading them can evict pages, but not the
+            // frames already in the message.  They are all valid, so the
+            // copies cannot fail.
+            if (!moved) {
+                ReadBufferFromUser(userAddress + i * PAGE_SIZE,
+                                   &mainMemory[frame * PAGE_SIZE], PAGE_SIZE);
+                stats->numMessageBytesCopied += PAGE_SIZE;
+            }
+            message->frames[i] = frame;
+        }
+        DEBUG('e', "Message of %u pages at %d taken out of the sender\n",
+              numPages, userAddress);
+        return message;
+    }
+#endif
+
+    if (size > 0) {
+        message->data = new char [size];
+        if (!ReadBufferFromUser(userAddress, message->data, size)) {
+            delete [] message->data;
+            delete message;
+            return nullptr;
+        }
+        stats->numMessageBytesCopied += size;
+    }
+    return message;
+}
+
+int
+MessageToUser(Message *message, int userAddress, unsigned size)
+{
+    ASSERT(message != nullptr);
+
+    unsigned stored = message->size < size ? message->size : size;
+    bool written = true;
+
+#ifdef SWAP
+    if (message->frames != nullptr) {
+        char *mainMemory = machine->GetMMU()->mainMemory;
+        for (unsigned i = 0; i < message->size / PAGE_SIZE; i++) {
+            unsigned frame  = message->frames[i];
+            unsigned offset = i * PAGE_SIZE;
+
+            bool mapped = false;
+            if (userAddress % PAGE_SIZE == 0 && offset + PAGE_SIZE <= stored) {
+                coreMapLock->Acquire();
+                mapped = currentThread->space->AdoptPage(
+                           userAddress / PAGE_SIZE + i, frame);
+                if (mapped) {
+                    coreMap[frame]->inTransit = false;
+                    framesInTransit--;
+                    stats->numMessagePagesRemapped++;
+                }
+                coreMapLock->Release();
+            }
+
+            if (written && !mapped && offset < stored) {
+                unsigned count = stored - offset < PAGE_SIZE ? stored - offset
+                                                             : PAGE_SIZE;
+                written = WriteBufferToUser(&mainMemory[frame * PAGE_SIZE],
+                                            userAddress + offset, count);
+                if (written) {
+                    stats->numMessageBytesCopied += count;
+                }
+            }
+            if (!mapped) {
+                coreMapLock->Acquire();
+                FreeTransitFrame(frame);
+                coreMapLock->Release();
+            }
+        }
+        zeroDaemon->Wake();
+
+        delete [] message->frames;
+        delete message;
+        return written ? (int) stored : -1;
+    }
+#endif
+
+    if (stored > 0) {
+        written = WriteBufferToUser(message->data, userAddress, stored);
+        if (written) {
+            stats->numMessageBytesCopied += stored;
+        }
+    }
+    delete [] message->data;
+    delete message;
+    return written ? (int) stored : -1;
+}
+
+
+MessageQueue::MessageQueue(int keyParam)
+{
+    key      = keyParam;
+    messages = new List<Message *>;
+    count    = 0;
+    lock     = new Lock("message queue");
+    notEmpty = new Condition("message queue not empty", lock);
+    notFull  = new Condition("message queue not full", lock);
+}
+
+MessageQueue::~MessageQueue()
+{
+    // Only at shutdown can messages be left; their frames go away with the
+    // machine.
+    while (!messages->IsEmpty()) {
+        Message *message = messages->Pop();
+        delete [] message->data;
+        delete [] message->frames;
+        delete message;
+    }
+    delete messages;
+    delete notFull;
+    delete notEmpty;
+    delete lock;
+}
+
+int
+MessageQueue::GetKey() const
+{
+    return key;
+}
+
+void
+MessageQueue::Send(Message *message)
+{
+    ASSERT(message != nullptr);
+
+    lock->Acquire();
+    while (count == MSG_QUEUE_LENGTH) {
+        notFull->Wait();
+    }
+    messages->Append(message);
+    count++;
+    notEmpty->Signal();
+    lock->Release();
+    stats->numMessagesSent++;
+
+    DEBUG('e', "Sent %u bytes on queue %d\n", message->size, key);
+}
+
+Message *
+MessageQueue::Receive()
+{
+    lock->Acquire();
+    while (count == 0) {
+        notEmpty->Wait();
+    }
+    Message *message = messages->Pop();
+    count--;
+    notFull->Signal();
+    lock->Release();
+
+    DEBUG('e', "Received %u bytes from queue %d\n", message->size, key);
+    return message;
+}
+
+bool
+MessageQueue::IsEmpty()
+{
+    lock->Acquire();
+    bool empty = count == 0;
+    lock->Release();
+    return empty;
+}
+
+
+MessageQueues::MessageQueues()
+{
+    for (unsigned i = 0; i < MAX_MESSAGE_QUEUES; i++) {
+        entries[i].queue = nullptr;
+        entries[i].users = 0;
+    }
+    lock = new Lock("message queues");
+}
+
+MessageQueues::~MessageQueues()
+{
+    for (unsigned i = 0; i < MAX_MESSAGE_QUEUES; i++) {
+        delete entries[i].queue;
+    }
+    delete lock;
+}
+
+MessageQueue *
+MessageQueues::Open(int key)
+{
+    lock->Acquire();
+    Entry *free = nullptr;
+    for (unsigned i = 0; i < MAX_MESSAGE_QUEUES; i++) {
+        Entry *entry = &entries[i];
+        if (entry->queue != nullptr && entry->queue->GetKey() == key) {
+            entry->users++;
+            lock->Release();
+            return entry->queue;
+        }
+        if (entry->queue == nullptr && free == nullptr) {
+            free = entry;
+        }
+    }
+
+    MessageQueue *queue = nullptr;
+    if (free != nullptr) {
+        DEBUG('e', "Creating message queue %d\n", key);
+        queue = free->queue = new MessageQueue(key);
+        free->users = 1;
+    }
+    lock->Release();
+    return queue;
+}
+
+void
+MessageQueues::Close(MessageQueue *queue)
+{
+    ASSERT(queue != nullptr);
+
+    lock->Acquire();
+    for (unsigned i = 0; i < MAX_MESSAGE_QUEUES; i++) {
+        Entry *entry = &entries[i];
+        if (entry->queue != queue) {
+            continue;
+        }
+        ASSERT(entry->users > 0);
+        if (--entry->users == 0 && queue->IsEmpty()) {
+            DEBUG('e', "Destroying message queue %d\n", queue->GetKey());
+            delete queue;
+            entry->queue = nullptr;
+        }
+        break;
+    }
+    lock->Release();
+}
@@ -0,0 +1,121 @@
+/// Message queues between user processes.
+///
+/// A queue is named by a key chosen by the processes that use it (see
+/// `MsgSend` and `MsgRecv` in `syscall.h`); it comes into existence with
+/// its first use, and goes away once it is empty and nobody uses it.
+///
+/// Small messages are copied into the kernel when they are sent, and out of
+/// it when they are received.  With `SWAP`, a message that starts at a page
+/// boundary and fills whole pages is not copied: its frames are taken out
+/// of the page table of the sender, wait in the queue out of every page
+/// table, and are mapped into the page table of the receiver, if its buffer
+/// is page-aligned too.  The core map follows each frame to its new owner.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_MESSAGEQUEUE__HH
+#define NACHOS_USERPROG_MESSAGEQUEUE__HH
+
+
+#include "lib/list.hh"
+#include "threads/condition.hh"
+#include "threads/lock.hh"
+
+
+/// Number of messages a queue holds before senders have to wait.
+const unsigned MSG_QUEUE_LENGTH = 8;
+
+/// Number of queues that can exist at once.
+const unsigned MAX_MESSAGE_QUEUES = 32;
+
+/// With `SWAP`, frames waiting in queues cannot be evicted, so only one in
+/// this many frames can be in a message at a time.  Messages that do not
+/// fit are copied.
+const unsigned MSG_TRANSIT_FRACTION = 4;
+
+/// A message waiting in a queue.
+struct Message {
+    unsigned size;
+    char *data;        ///< Copy of the message, or null if it is in `frames`.
+    unsigned *frames;  ///< Frames holding the pages of the message, which no
+                       ///< page table maps (`SWAP` only).
+};
+
+/// Build a message out of the `size` bytes at `userAddress` in the current
+/// address space.  Whole pages are moved instead of copied when possible,
+/// and then the sender no longer has them.  Return null if the bytes are
+/// not in the memory of the program.
+Message *MessageFromUser(int userAddress, unsigned size);
+
+/// Store up to `size` bytes of `message` at `userAddress` in the current
+/// address space, mapping its frames there when possible, and destroy it.
+/// Return how many bytes were stored, or -1 if the buffer is not in the
+/// memory of the program.
+int MessageToUser(Message *message, int userAddress, unsigned size);
+
+class MessageQueue {
+public:
+
+    MessageQueue(int key);
+
+    /// Destroy the queue, and the messages left in it.
+    ~MessageQueue();
+
+    int GetKey() const;
+
+    /// Append `message`, waiting while the queue is full.
+    void Send(Message *message);
+
+    /// Wait until there is a message, and take the oldest one.
+    Message *Receive();
+
+    /// Whether the queue holds no messages.
+    bool IsEmpty();
+
+private:
+
+    int key;
+
+    List<Message *> *messages;
+    unsigned count;
+
+    Lock *lock;
+    Condition *notEmpty;
+    Condition *notFull;
+};
+
+/// Every queue, by key.
+class MessageQueues {
+public:
+
+    MessageQueues();
+
+    ~MessageQueues();
+
+    /// Return the queue of `key`, creating it if there is none, or null if
+    /// there are too many queues already.  Every queue returned must be
+    /// given back with `Close`.
+    MessageQueue *Open(int key);
+
+    /// Give `queue` back.  It is destroyed if it is empty and nobody else
+    /// has it open.
+    void Close(MessageQueue *queue);
+
+private:
+
+    /// A queue, and how many system calls have it open.  Free entries
+    /// have no queue.
+    struct Entry {
+        MessageQueue *queue;
+        unsigned users;
+    };
+
+    Entry entries[MAX_MESSAGE_QUEUES];
+
+    Lock *lock;
+};
+
+
+#endif
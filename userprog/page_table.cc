@@ -0,0 +1,176 @@
+/// Routines to manage two-level page tables.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "page_table.hh"
+#include "lib/utility.hh"
+
+#include <limits.h>
+#include <string.h>
+
+
+PageTable::PageTable()
+{
+    directory     = nullptr;
+#ifdef SWAP
+    slots         = nullptr;
+#endif
+    directorySize = 0;
+    numPages      = 0;
+}
+
+PageTable::~PageTable()
+{
+    for (unsigned i = 0; i < directorySize; i++) {
+        delete [] directory[i];
+#ifdef SWAP
+        delete [] slots[i];
+#endif
+    }
+    delete [] directory;
+#ifdef SWAP
+    delete [] slots;
+#endif
+}
+
+void
+PageTable::Resize(unsigned newNumPages)
+{
+    unsigned newDirectorySize = DivRoundUp(newNumPages, PAGE_TABLE_ENTRIES);
+
+    if (newNumPages < numPages) {
+        // The entries past the end must look unused if the table grows
+        // again.
+        ClearFrom(newNumPages);
+        for (unsigned i = newDirectorySize; i < directorySize; i++) {
+            delete [] directory[i];
+            directory[i] = nullptr;
+#ifdef SWAP
+            delete [] slots[i];
+            slots[i] = nullptr;
+#endif
+        }
+    }
+
+    // The directory itself only ever grows, it is a few pointers.
+    if (newDirectorySize > directorySize) {
+        TranslationEntry **newDirectory = new TranslationEntry *[newDirectorySize];
+        memset(newDirectory, 0, newDirectorySize * sizeof *newDirectory);
+        if (directory != nullptr) {
+            memcpy(newDirectory, directory, directorySize * sizeof *directory);
+        }
+        delete [] directory;
+        directory = newDirectory;
+#ifdef SWAP
+        int **newSlots = new int *[newDirectorySize];
+        memset(newSlots, 0, newDirectorySize * sizeof *newSlots);
+        if (slots != nullptr) {
+            memcpy(newSlots, slots, directorySize * sizeof *slots);
+        }
+        delete [] slots;
+        slots = newSlots;
+#endif
+        directorySize = newDirectorySize;
+    }
+
+    numPages = newNumPages;
+}
+
+unsigned
+PageTable::GetNumPages() const
+{
+    return numPages;
+}
+
+TranslationEntry &
+PageTable::operator[](unsigned vpn)
+{
+    ASSERT(vpn < numPages);
+
+    unsigned index = vpn / PAGE_TABLE_ENTRIES;
+    if (directory[index] == nullptr) {
+        AllocTable(index);
+    }
+    return directory[index][vpn % PAGE_TABLE_ENTRIES];
+}
+
+TranslationEntry *
+PageTable::Find(unsigned vpn) const
+{
+    if (vpn >= numPages) {
+        return nullptr;
+    }
+
+    TranslationEntry *table = directory[vpn / PAGE_TABLE_ENTRIES];
+    return table == nullptr ? nullptr : &table[vpn % PAGE_TABLE_ENTRIES];
+}
+
+#ifdef SWAP
+int &
+PageTable::SwapSlot(unsigned vpn)
+{
+    ASSERT(vpn < numPages);
+
+    unsigned index = vpn / PAGE_TABLE_ENTRIES;
+    if (directory[index] == nullptr) {
+        AllocTable(index);
+    }
+    return slots[index][vpn % PAGE_TABLE_ENTRIES];
+}
+#endif
+
+TranslationEntry **
+PageTable::GetDirectory() const
+{
+    return directory;
+}
+
+unsigned
+PageTable::CountTables() const
+{
+    unsigned count = 0;
+    for (unsigned i = 0; i < directorySize; i++) {
+        if (directory[i] != nullptr) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void
+PageTable::AllocTable(unsigned index)
+{
+    ASSERT(index < directorySize);
+    ASSERT(directory[index] == nullptr);
+
+    directory[index] = new TranslationEntry [PAGE_TABLE_ENTRIES];
+#ifdef SWAP
+    slots[index] = new int [PAGE_TABLE_ENTRIES];
+#endif
+    ClearFrom(index * PAGE_TABLE_ENTRIES);
+}
+
+void
+PageTable::ClearFrom(unsigned first)
+{
+    unsigned index = first / PAGE_TABLE_ENTRIES;
+    if (index >= directorySize || directory[index] == nullptr) {
+        return;
+    }
+
+    for (unsigned i = first % PAGE_TABLE_ENTRIES; i < PAGE_TABLE_ENTRIES; i++) {
+        TranslationEntry *entry = &directory[index][i];
+        entry->virtualPage  = index * PAGE_TABLE_ENTRIES + i;
+        entry->physicalPage = INT_MAX;
+        entry->valid        = false;
+        entry->readOnly     = false;
+        entry->use          = false;
+        entry->dirty        = false;
+#ifdef SWAP
+        slots[index][i] = -1;
+#endif
+    }
+}
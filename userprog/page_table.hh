@@ -0,0 +1,83 @@
+/// Two-level page tables.
+///
+/// The virtual pages of an address space are split in groups of
+/// `PAGE_TABLE_ENTRIES`, and the first level of the table (the directory)
+/// has a pointer to the second-level table of each group.  Second-level
+/// tables are only allocated when one of their entries is first needed, so
+/// the memory taken by the table grows with the pages that are used, not
+/// with the size of the address space.
+///
+/// The directory is the format the MMU walks when there is no TLB (see
+/// `MMU::pageTable`).  With `SWAP`, every second-level table also records
+/// the swap slot of each of its pages.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_PAGETABLE__HH
+#define NACHOS_USERPROG_PAGETABLE__HH
+
+
+#include "machine/mmu.hh"
+#include "machine/translation_entry.hh"
+
+
+class PageTable {
+public:
+
+    /// Create an empty table, covering no pages.
+    PageTable();
+
+    /// Free every second-level table.
+    ~PageTable();
+
+    /// Make the table cover `numPages` pages.  Pages that are added start
+    /// out invalid and out of memory; second-level tables that end up
+    /// wholly past the last page are freed.
+    void Resize(unsigned numPages);
+
+    unsigned GetNumPages() const;
+
+    /// Return the entry of page `vpn`, allocating its second-level table
+    /// if needed.
+    TranslationEntry &operator[](unsigned vpn);
+
+    /// Return the entry of page `vpn`, or null if its second-level table
+    /// was never allocated, and so the page was never used.
+    TranslationEntry *Find(unsigned vpn) const;
+
+#ifdef SWAP
+    /// Return the swap slot of page `vpn` (-1 if none), allocating its
+    /// second-level table if needed.
+    int &SwapSlot(unsigned vpn);
+#endif
+
+    /// Return the directory, for the MMU.
+    TranslationEntry **GetDirectory() const;
+
+    /// Number of second-level tables allocated.
+    unsigned CountTables() const;
+
+private:
+
+    /// Allocate the second-level table number `index`.
+    void AllocTable(unsigned index);
+
+    /// Reset the entries from `first` to the end of their second-level
+    /// table, if it is allocated.
+    void ClearFrom(unsigned first);
+
+    TranslationEntry **directory;
+#ifdef SWAP
+    int **slots;
+#endif
+
+    /// Entries of `directory`.
+    unsigned directorySize;
+
+    unsigned numPages;
+};
+
+
+#endif
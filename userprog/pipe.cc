@@ -0,0 +1,153 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "pipe.hh"
+#include "lib/utility.hh"
+
+#include <string.h>
+
+
+PipeBuffer::PipeBuffer()
+{
+    head     = 0;
+    count    = 0;
+    readers  = 0;
+    writers  = 0;
+    lock     = new Lock("pipe");
+    notEmpty = new Condition("pipe not empty", lock);
+    notFull  = new Condition("pipe not full", lock);
+}
+
+PipeBuffer::~PipeBuffer()
+{
+    ASSERT(readers == 0 && writers == 0);
+
+    delete notFull;
+    delete notEmpty;
+    delete lock;
+}
+
+int
+PipeBuffer::Read(char *into, int size)
+{
+    ASSERT(into != nullptr);
+    ASSERT(size > 0);
+
+    lock->Acquire();
+    while (count == 0 && writers > 0) {
+        notEmpty->Wait();
+    }
+
+    unsigned total = count < (unsigned) size ? count : size;
+    for (unsigned done = 0; done < total; ) {
+        // The data may wrap around the end of the buffer.
+        unsigned chunk = PIPE_SIZE - head;
+        if (chunk > total - done) {
+            chunk = total - done;
+        }
+        memcpy(into + done, &buffer[head], chunk);
+        head   = (head + chunk) % PIPE_SIZE;
+        count -= chunk;
+        done  += chunk;
+    }
+    if (total > 0) {
+        notFull->Broadcast();
+    }
+    lock->Release();
+
+    DEBUG('e', "Read %u bytes from pipe %p\n", total, this);
+    return total;
+}
+
+int
+PipeBuffer::Write(const char *from, int size)
+{
+    ASSERT(from != nullptr);
+    ASSERT(size > 0);
+
+    lock->Acquire();
+    unsigned done = 0;
+    while (done < (unsigned) size && readers > 0) {
+        if (count == PIPE_SIZE) {
+            notFull->Wait();
+            continue;
+        }
+        unsigned tail  = (head + count) % PIPE_SIZE;
+        unsigned chunk = (tail >= head ? PIPE_SIZE : head) - tail;
+        if (chunk > size - done) {
+            chunk = size - done;
+        }
+        memcpy(&buffer[tail], from + done, chunk);
+        count += chunk;
+        done  += chunk;
+        notEmpty->Broadcast();
+    }
+    lock->Release();
+
+    DEBUG('e', "Wrote %u bytes of %d into pipe %p\n", done, size, this);
+    return done;
+}
+
+void
+PipeBuffer::Open(bool writing)
+{
+    lock->Acquire();
+    if (writing) {
+        writers++;
+    } else {
+        readers++;
+    }
+    lock->Release();
+}
+
+bool
+PipeBuffer::Close(bool writing)
+{
+    lock->Acquire();
+    if (writing) {
+        ASSERT(writers > 0);
+        if (--writers == 0) {
+            notEmpty->Broadcast();  // Readers get to the end of the data.
+        }
+    } else {
+        ASSERT(readers > 0);
+        if (--readers == 0) {
+            notFull->Broadcast();   // Writers have nobody to write to.
+        }
+    }
+    bool unused = readers == 0 && writers == 0;
+    lock->Release();
+
+    return unused;
+}
+
+
+PipeEnd::PipeEnd(PipeBuffer *pipeParam, bool writingParam)
+{
+    ASSERT(pipeParam != nullptr);
+
+    pipe    = pipeParam;
+    writing = writingParam;
+    pipe->Open(writing);
+}
+
+PipeEnd::~PipeEnd()
+{
+    if (pipe->Close(writing)) {
+        delete pipe;
+    }
+}
+
+PipeBuffer *
+PipeEnd::GetPipe() const
+{
+    return pipe;
+}
+
+bool
+PipeEnd::IsWriting() const
+{
+    return writing;
+}
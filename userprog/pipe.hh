@@ -0,0 +1,84 @@
+/// Pipes between user processes.
+///
+/// A pipe is a buffer in the kernel with a read end and a write end, each
+/// one an `OpenFileId` of the process that holds it (see `Pipe` and
+/// `ExecRedirect` in `syscall.h`).  Reading waits until there is data, and
+/// writing waits until there is room, so the processes at both ends run
+/// concurrently, without going through the disk.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_PIPE__HH
+#define NACHOS_USERPROG_PIPE__HH
+
+
+#include "threads/condition.hh"
+#include "threads/lock.hh"
+
+
+/// Capacity of the buffer of a pipe, in bytes.
+const unsigned PIPE_SIZE = 1024;
+
+/// The buffer shared by both ends.  It is deleted along with the last end.
+class PipeBuffer {
+public:
+
+    PipeBuffer();
+
+    ~PipeBuffer();
+
+    /// Wait until there is data, and move up to `size` bytes of it into
+    /// `buffer`.  Return how many, or 0 if the pipe is empty and has no
+    /// writers left.
+    int Read(char *buffer, int size);
+
+    /// Write the `size` bytes of `buffer`, waiting for room as needed.
+    /// Return how many were written, which is less than `size` only if
+    /// there are no readers left.
+    int Write(const char *buffer, int size);
+
+    /// Count a new end.
+    void Open(bool writing);
+
+    /// Forget an end, and wake up whoever waits for it.  Return whether
+    /// the pipe has no ends left.
+    bool Close(bool writing);
+
+private:
+
+    char buffer[PIPE_SIZE];
+    unsigned head;   ///< Next byte to read.
+    unsigned count;  ///< Bytes in the buffer.
+
+    unsigned readers;
+    unsigned writers;
+
+    Lock *lock;
+    Condition *notEmpty;  ///< Data arrived, or the last writer left.
+    Condition *notFull;   ///< Room was made, or the last reader left.
+};
+
+/// An end of a pipe, held by a process.
+class PipeEnd {
+public:
+
+    /// Open an end of `pipe`, for writing or for reading.
+    PipeEnd(PipeBuffer *pipe, bool writing);
+
+    /// Close the end, and the pipe with it if it was the last one.
+    ~PipeEnd();
+
+    PipeBuffer *GetPipe() const;
+
+    bool IsWriting() const;
+
+private:
+
+    PipeBuffer *pipe;
+    bool writing;
+};
+
+
+#endif
@@ -90,8 +90,11 @@ ConsoleTest(const char *in, const char *out)
     writeDone = new Semaphore("write done", 0);
 
     for (;;) {
-        readAvail->P();        // Wait for character to arrive.
         char ch = console->GetChar();
+        if (ch == EOF) {
+            readAvail->P();    // Wait for characters to arrive.
+            continue;
+        }
         console->PutChar(ch);  // Echo it!
         writeDone->P();        // Wait for write to finish.
         if (ch == 'q') {
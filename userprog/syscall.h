@@ -33,6 +33,27 @@
 #define SC_WRITE   15
 #define SC_LSDIR   16
 #define SC_CD      17
+#define SC_MMAP    18
+#define SC_MUNMAP  19
+#define SC_SHMCREATE  20
+#define SC_SHMATTACH  21
+#define SC_SHMDETACH  22
+#define SC_SBRK       23
+#define SC_SEEK       24
+#define SC_PREAD      25
+#define SC_PWRITE     26
+#define SC_READV      27
+#define SC_WRITEV     28
+#define SC_IOSETUP    29
+#define SC_IOENTER    30
+#define SC_EXECREDIRECT 31
+#define SC_PIPE       32
+#define SC_MSGSEND    33
+#define SC_MSGRECV    34
+#define SC_COPYFILE   35
+#define SC_THREADCREATE 36
+#define SC_FUTEXWAIT  37
+#define SC_FUTEXWAKE  38
 
 #ifndef IN_ASM
 
@@ -44,14 +65,22 @@
 /// register, and traps to the kernel.  The kernel procedures are then
 /// invoked in the Nachos kernel, after appropriate error checking, from the
 /// system call entry point in exception.cc.
+///
+/// A system call handed an address outside the memory of the program fails
+/// like it does for any other invalid argument; `Read`, `Write` and their
+/// variants return -1 then.
 
 /// Stop Nachos, and print out performance stats.
 void Halt();
 
 
-/// Address space control operations: `Exit`, `Exec`, and `Join`.
+/// Address space control operations: `Exit`, `Exec`, `Fork` and `Join`.
 
 /// This user program is done (`status = 0` means exited normally).
+///
+/// Called from a thread created with `ThreadCreate`, only that thread ends,
+/// and `status` goes to whoever joins it.  Called from the main thread, the
+/// process ends once its other threads have ended.
 void Exit(int status);
 
 /// An unique identifier for an executing user program (address space).
@@ -61,25 +90,50 @@ typedef int SpaceId;
 /// address space identifier.
 SpaceId Exec(char *name, char** argv, int isJoinable);
 
+/// Create a new process running a copy of the calling one, which goes on
+/// right after the call.
+///
+/// Return the identifier of the new process to the caller, and 0 to the new
+/// process.  The memory of the caller is shared copy-on-write; open files
+/// other than the console are not inherited.
+SpaceId Fork(int isJoinable);
+
 /// Only return once the the user program `id` has finished.
 ///
 /// Return the exit status.
 int Join(SpaceId id);
 
 
-/// User-level thread operations: `Fork` and `Yield`.  To allow multiple
-/// threads to run within a user program.
+/// User-level thread operations: `ThreadCreate`, `Yield`, `FutexWait` and
+/// `FutexWake`.
 
-/// Fork a thread to run a procedure (`func`) in the *same* address space as
-/// the current thread.
-int Fork(void (*func)(void));
+/// Start a new thread of this process running `func(arg)`, in the same
+/// address space, on a stack of its own taken from the heap.  The thread
+/// ends when `func` returns, with its result as the status, or when it
+/// calls `Exit`.
+///
+/// Return an identifier that `Join` takes if `isJoinable`, or -1 if the
+/// process has too many threads already.  Joinable threads must be joined.
+SpaceId ThreadCreate(int (*func)(void *), void *arg, int isJoinable);
 
 /// Yield the CPU to another runnable thread, whether in this address space
 /// or not.
 void Yield();
 
+/// If the word at `address` still holds `value`, sleep until a `FutexWake`
+/// on it, and return 0; otherwise return -1 right away.  The check and the
+/// sleep happen at once with respect to `FutexWake`, so a lock can be
+/// built by sleeping on its word while it is taken, instead of spinning on
+/// `Yield`.  Only threads of the same process meet on a word.
+int FutexWait(int *address, int value);
+
+/// Wake up to `count` threads sleeping on the word at `address`, oldest
+/// first, and return how many were woken.
+int FutexWake(int *address, int count);
 
-/// File system operations: `Create`, `Open`, `Read`, `Write`, `Close`.
+
+/// File system operations: `Create`, `Open`, `Read`, `Write`, `Seek`,
+/// `PRead`, `PWrite`, `ReadV`, `WriteV`, `Close`.
 ///
 /// These functions are patterned after UNIX -- files represent both files
 /// *and* hardware I/O devices.
@@ -117,12 +171,228 @@ int Write(const char *buffer, int size, OpenFileId id);
 /// Return the number of bytes actually read -- if the open file is not long
 /// enough, or if it is an I/O device, and there are not enough characters to
 /// read, return whatever is available (for I/O devices, you should always
-/// wait until you can return at least one character).
+/// wait until you can return at least one character).  Reading from the
+/// console returns at most one line, newline included.
 int Read(char *buffer, int size, OpenFileId id);
 
+/// Where `Seek` counts the offset from.
+#define SEEK_FROM_START    0
+#define SEEK_FROM_CURRENT  1
+#define SEEK_FROM_END      2
+
+/// Move the position of the open file from which the next `Read` or
+/// `Write` starts, to `offset` bytes from its start, from the current
+/// position or from its end, as told by `whence`.
+///
+/// Return the new position, or -1 in case of error, including positions
+/// past the end of the file.
+int Seek(OpenFileId id, int offset, int whence);
+
+/// Maximum number of bytes that `Read`, `Write`, `PRead`, `PWrite`, `ReadV`
+/// and `WriteV` transfer in a single call.
+#define MAX_IO_SIZE  65536
+
+/// Like `Read` and `Write`, but starting at byte `position` of the file,
+/// and without moving the position of the open file.  They do not work on
+/// the console, and writes cannot start past the end of the file.  At most
+/// `MAX_IO_SIZE` bytes are transferred.
+int PRead(char *buffer, int size, OpenFileId id, int position);
+int PWrite(const char *buffer, int size, OpenFileId id, int position);
+
+/// A buffer for `ReadV` and `WriteV`.
+typedef struct {
+    char *buffer;
+    int size;
+} IoVec;
+
+/// Maximum number of buffers for `ReadV` and `WriteV`.
+#define MAX_IOVEC  16
+
+/// Like `Read` and `Write`, but scattering the data into, or gathering it
+/// from, the `count` buffers of `vector`, in order.  The file is accessed
+/// once, as if the buffers were contiguous.  The sizes cannot add up to
+/// more than `MAX_IO_SIZE` bytes.
+int ReadV(const IoVec *vector, int count, OpenFileId id);
+int WriteV(const IoVec *vector, int count, OpenFileId id);
+
+/// Copy up to `length` bytes from the open file `from` to the open file
+/// `to`, inside the kernel, starting at the position of each and moving
+/// both.  Either one may be the console or a pipe, so that
+/// `CopyFile(id, CONSOLE_OUTPUT, length)` prints a file.  The copy stops
+/// short at the end of `from`, or when the console or a pipe has nothing
+/// more to read for now, just like `Read`.
+///
+/// Return the number of bytes copied, 0 at the end of `from` or in case of
+/// error, or -1 if `length` is not positive.
+int CopyFile(OpenFileId from, OpenFileId to, int length);
+
 /// Close the file, we are done reading and writing to it.
+///
+/// Mappings of the file are removed too.
 int Close(OpenFileId id);
 
+/// Pipes: `Pipe`, `ExecRedirect`.
+///
+/// A pipe is a buffer in the kernel, with an end to read from and an end to
+/// write to, which work with `Read`, `Write`, `ReadV`, `WriteV`, `Close`
+/// and asynchronous requests, and can be handed to new processes with
+/// `ExecRedirect`.  `Read` waits until there is data, and returns 0 once
+/// every write end is closed and the data is over.  `Write` waits for room,
+/// and stops short if every read end is closed.
+
+/// Create a pipe, and store the id of its read end in `ends[0]` and that of
+/// its write end in `ends[1]`.
+///
+/// Return 0 on success, -1 in case of error.
+int Pipe(OpenFileId *ends);
+
+/// Like `Exec`, but the new process reads its `CONSOLE_INPUT` from
+/// `streams[0]` and writes its `CONSOLE_OUTPUT` to `streams[1]`.  Each one
+/// is either the console id itself, or the id of a pipe end of the caller
+/// in the right direction, which the new process gets a copy of.
+SpaceId ExecRedirect(char *name, char **argv, int isJoinable,
+                     const OpenFileId *streams);
+
+/// Asynchronous I/O: `IoSetup`, `IoEnter`.
+///
+/// A process registers a ring: a region of its memory that holds an
+/// `IoRingHeader`, followed by `entries` submissions and `entries`
+/// completions.  It queues requests by filling submissions and advancing
+/// `submitTail`, and hands them to the kernel with `IoEnter`.  Kernel
+/// threads carry them out while the process goes on, and their results come
+/// back as completions, which the process consumes by advancing
+/// `completeHead`.
+///
+/// Indices only grow; the slot of index `i` is `i % entries`.  Completions
+/// are written into the ring whenever the process calls `IoEnter`, in the
+/// order requests finish, which need not be the order they were submitted.
+///
+/// Requests at a position leave the position of the file alone, so the
+/// process can go on using the file.  While requests that use the position
+/// are in flight, the file should not be read, written or sought by other
+/// means.  `Close` waits for the requests in flight on the file it closes,
+/// and `Exit` for those on any file; requests on pipes and the console are
+/// left to end on their own.
+
+/// Indices of the ring.  Each one is only written by one side.
+typedef struct {
+    unsigned submitHead;    ///< Next submission to take; kernel.
+    unsigned submitTail;    ///< Next free submission; program.
+    unsigned completeHead;  ///< Next completion to consume; program.
+    unsigned completeTail;  ///< Next free completion; kernel.
+} IoRingHeader;
+
+/// Operations of a submission.
+#define IO_OP_NOP    0
+#define IO_OP_READ   1
+#define IO_OP_WRITE  2
+
+typedef struct {
+    int opcode;
+    OpenFileId id;
+    char *buffer;
+    int size;       ///< At most `MAX_IO_SIZE` bytes are transferred.
+    int position;   ///< Where in the file, as in `PRead`/`PWrite`, or -1
+                    ///< to use, and move, the position of the file.
+    int userData;   ///< Copied into the completion.
+} IoSubmission;
+
+typedef struct {
+    int userData;
+    int result;     ///< Bytes read or written, or -1 in case of error.
+} IoCompletion;
+
+/// Maximum number of entries of a ring; it must be a power of two.
+#define IO_RING_MAX_ENTRIES  64
+
+/// Register the ring at `ring`, with `entries` submissions and as many
+/// completions, and set its indices to 0.  A previous ring of the thread
+/// is replaced, if it has no requests pending.  Each thread of a process
+/// has a ring of its own.
+///
+/// Return 0 on success, -1 in case of error.
+int IoSetup(void *ring, int entries);
+
+/// Hand up to `toSubmit` queued submissions to the kernel, write the
+/// completions of finished requests into the ring, and if `minComplete` is
+/// not 0, wait until at least that many completions are there or no
+/// request is left pending.
+///
+/// Return the number of requests submitted, or -1 if there is no ring, or
+/// it is not in the memory of the process.
+int IoEnter(int toSubmit, int minComplete);
+
+/// Map the first `length` bytes of the open file into memory, or all of it
+/// if `length` is 0, and return the address of the mapping (0 on error).
+///
+/// The file is read as the mapped pages are referenced, and modified pages
+/// are written back to it.  Mappings are not inherited by `Fork`, and they
+/// are removed on `Exit`.
+void *Mmap(OpenFileId id, int length);
+
+/// Write back and remove the mapping that starts at `address`.
+///
+/// Return 0 on success, -1 if there is no such mapping.
+int Munmap(void *address);
+
+/// Create a shared memory segment of `size` bytes, initially zero.
+///
+/// Return an identifier that any process can pass to `ShmAttach`, or -1 in
+/// case of error.
+int ShmCreate(int size);
+
+/// Map the segment `id` into the address space of the calling process.
+///
+/// Segments are not inherited by `Fork`; children attach to them
+/// explicitly, and may get them at a different address.
+///
+/// Return the address of the segment, or 0 in case of error.
+void *ShmAttach(int id);
+
+/// Remove the segment mapped at `address`.  Processes detach from their
+/// segments on `Exit` as well, and a segment is destroyed along with its
+/// last attachment.
+///
+/// Return 0 on success, -1 if there is no segment at `address`.
+int ShmDetach(void *address);
+
+/// Message queues: `MsgSend`, `MsgRecv`.
+///
+/// A queue is named by a key, any number the processes that use it agree
+/// on; it exists from its first use until it is empty and nobody waits on
+/// it.  Messages are received whole, in the order they were sent, by a
+/// single receiver each.
+///
+/// Messages are copied, except those that start at a page boundary and
+/// take whole pages: their pages are moved out of the sender, and into the
+/// receiver, when its buffer starts at a page boundary too.  After sending
+/// such a message, the buffer reads as it did when the program started
+/// (zero, in the heap and the stack), instead of holding the message.
+
+/// Maximum size of a message, in bytes.
+#define MSG_MAX_SIZE  4096
+
+/// Append the `size` bytes at `buffer` to the queue `key`, waiting while
+/// the queue is full.
+///
+/// Return 0 on success, -1 in case of error.
+int MsgSend(int key, const void *buffer, int size);
+
+/// Wait for a message on the queue `key`, and store up to `size` bytes of
+/// it at `buffer`; the rest of a longer message is lost.
+///
+/// Return the number of bytes stored, or -1 in case of error.
+int MsgRecv(int key, void *buffer, int size);
+
+/// Grow the heap of the calling process by `increment` bytes.
+///
+/// The new memory reads as zero, and only takes physical memory once it is
+/// touched.  The heap cannot shrink.
+///
+/// Return the previous end of the heap, that is, the start of the new
+/// memory, or -1 in case of error.
+void *Sbrk(int increment);
+
 /// Show the content of the current directory
 void Ls(char *buffer);
 
@@ -0,0 +1,276 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "syscall_stats.hh"
+#include "syscall.h"
+#include "threads/system.hh"
+
+#include <string.h>
+
+
+/// Names of the system calls, and how many arguments they take.
+static const struct {
+    int scid;
+    const char *name;
+    unsigned numArgs;
+} SYSCALLS[] = {
+    { SC_HALT,      "Halt",      0 },
+    { SC_EXIT,      "Exit",      1 },
+    { SC_EXEC,      "Exec",      3 },
+    { SC_JOIN,      "Join",      1 },
+    { SC_FORK,      "Fork",      1 },
+    { SC_YIELD,     "Yield",     0 },
+    { SC_THREADCREATE, "ThreadCreate", 3 },
+    { SC_FUTEXWAIT,    "FutexWait",    2 },
+    { SC_FUTEXWAKE,    "FutexWake",    2 },
+    { SC_CREATE,    "Create",    2 },
+    { SC_REMOVE,    "Remove",    2 },
+    { SC_OPEN,      "Open",      1 },
+    { SC_CLOSE,     "Close",     1 },
+    { SC_READ,      "Read",      3 },
+    { SC_WRITE,     "Write",     3 },
+    { SC_LSDIR,     "Ls",        1 },
+    { SC_CD,        "Cd",        1 },
+    { SC_MMAP,      "Mmap",      2 },
+    { SC_MUNMAP,    "Munmap",    1 },
+    { SC_SHMCREATE, "ShmCreate", 1 },
+    { SC_SHMATTACH, "ShmAttach", 1 },
+    { SC_SHMDETACH, "ShmDetach", 1 },
+    { SC_SBRK,      "Sbrk",      1 },
+    { SC_SEEK,      "Seek",      3 },
+    { SC_PREAD,     "PRead",     4 },
+    { SC_PWRITE,    "PWrite",    4 },
+    { SC_READV,     "ReadV",     3 },
+    { SC_WRITEV,    "WriteV",    3 },
+    { SC_COPYFILE,  "CopyFile",  3 },
+    { SC_IOSETUP,   "IoSetup",   2 },
+    { SC_IOENTER,   "IoEnter",   2 },
+    { SC_EXECREDIRECT, "ExecRedirect", 4 },
+    { SC_PIPE,         "Pipe",         1 },
+    { SC_MSGSEND,      "MsgSend",      3 },
+    { SC_MSGRECV,      "MsgRecv",      3 },
+};
+
+static const unsigned NUM_NAMED_SYSCALLS = sizeof SYSCALLS / sizeof *SYSCALLS;
+
+static unsigned
+NumArgs(int scid)
+{
+    for (unsigned i = 0; i < NUM_NAMED_SYSCALLS; i++) {
+        if (SYSCALLS[i].scid == scid) {
+            return SYSCALLS[i].numArgs;
+        }
+    }
+    return 4;
+}
+
+/// Return how many bytes of data the call `scid` moved, given its result.
+/// The data of ring requests is added by `AddBytes` instead.
+static unsigned long
+BytesMoved(int scid, int result)
+{
+    switch (scid) {
+        case SC_READ:   case SC_WRITE:
+        case SC_PREAD:  case SC_PWRITE:
+        case SC_READV:  case SC_WRITEV:
+        case SC_MSGRECV: case SC_COPYFILE:
+            return result > 0 ? result : 0;
+        case SC_MSGSEND:
+            // The whole message is sent, or nothing.
+            return result == 0 ? machine->ReadRegister(6) : 0;
+        default:
+            return 0;
+    }
+}
+
+static SpaceSyscallStats *
+NewSpaceSyscallStats(int spaceId, const char *name)
+{
+    SpaceSyscallStats *space = new SpaceSyscallStats;
+    space->spaceId = spaceId;
+    strncpy(space->name, name, SYSCALL_STATS_NAME_LENGTH - 1);
+    space->name[SYSCALL_STATS_NAME_LENGTH - 1] = '\0';
+    memset(space->counters, 0, sizeof space->counters);
+    return space;
+}
+
+static void
+Count(SyscallCounter *counter, unsigned long ticks, unsigned long bytes)
+{
+    if (counter->calls == 0 || ticks < counter->minTicks) {
+        counter->minTicks = ticks;
+    }
+    if (ticks > counter->maxTicks) {
+        counter->maxTicks = ticks;
+    }
+    counter->calls++;
+    counter->totalTicks += ticks;
+    counter->bytes += bytes;
+}
+
+SyscallStats::SyscallStats(bool printParam, const char *fileNameParam,
+                           bool traceParam)
+{
+    print    = printParam;
+    fileName = fileNameParam;
+    trace    = traceParam;
+    for (unsigned i = 0; i < Table<int>::SIZE; i++) {
+        spaces[i] = nullptr;
+    }
+    all = NewSpaceSyscallStats(-1, "(all)");
+}
+
+SyscallStats::~SyscallStats()
+{
+    for (unsigned i = 0; i < Table<int>::SIZE; i++) {
+        delete spaces[i];
+    }
+    delete all;
+}
+
+const char *
+SyscallStats::Name(int scid)
+{
+    for (unsigned i = 0; i < NUM_NAMED_SYSCALLS; i++) {
+        if (SYSCALLS[i].scid == scid) {
+            return SYSCALLS[i].name;
+        }
+    }
+    return nullptr;
+}
+
+SpaceSyscallStats *
+SyscallStats::Current()
+{
+    // Threads created with `ThreadCreate` count for their process.
+    Thread *process = currentThread->GetProcess();
+    int spaceId = process->GetSpaceId();
+    ASSERT(spaceId >= 0 && (unsigned) spaceId < Table<int>::SIZE);
+
+    if (spaces[spaceId] == nullptr) {
+        spaces[spaceId] = NewSpaceSyscallStats(spaceId, process->GetName());
+    }
+    return spaces[spaceId];
+}
+
+/// Print the call in progress, with its arguments, followed by ` = `.
+static void
+LogCall(int scid)
+{
+    const char *name = SyscallStats::Name(scid);
+    if (name != nullptr) {
+        fprintf(stderr, "[%d] %s(", currentThread->GetSpaceId(), name);
+    } else {
+        fprintf(stderr, "[%d] syscall_%d(", currentThread->GetSpaceId(),
+                scid);
+    }
+    unsigned numArgs = NumArgs(scid);
+    for (unsigned i = 0; i < numArgs; i++) {
+        fprintf(stderr, i == 0 ? "%d" : ", %d", machine->ReadRegister(4 + i));
+    }
+    fprintf(stderr, ") = ");
+}
+
+void
+SyscallStats::Record(int scid, unsigned long ticks, int result)
+{
+    if (trace) {
+        LogCall(scid);
+        fprintf(stderr, "%d <%lu>\n", result, ticks);
+    }
+    if (scid < 0 || (unsigned) scid >= MAX_SYSCALLS) {
+        return;
+    }
+
+    unsigned long bytes = BytesMoved(scid, result);
+    Count(&Current()->counters[scid], ticks, bytes);
+    Count(&all->counters[scid], ticks, bytes);
+}
+
+void
+SyscallStats::RecordNoReturn(int scid)
+{
+    if (trace) {
+        LogCall(scid);
+        fprintf(stderr, "?\n");
+    }
+    if (scid < 0 || (unsigned) scid >= MAX_SYSCALLS) {
+        return;
+    }
+
+    Count(&Current()->counters[scid], 0, 0);
+    Count(&all->counters[scid], 0, 0);
+}
+
+void
+SyscallStats::AddBytes(int scid, unsigned long bytes)
+{
+    ASSERT(scid >= 0 && (unsigned) scid < MAX_SYSCALLS);
+
+    Current()->counters[scid].bytes += bytes;
+    all->counters[scid].bytes += bytes;
+}
+
+void
+SyscallStats::PrintSpace(FILE *file, const SpaceSyscallStats *space,
+                         bool tabular)
+{
+    char id[16];
+    if (space->spaceId < 0) {
+        strcpy(id, "*");
+    } else {
+        snprintf(id, sizeof id, "%d", space->spaceId);
+    }
+
+    for (unsigned scid = 0; scid < MAX_SYSCALLS; scid++) {
+        const SyscallCounter *c = &space->counters[scid];
+        if (c->calls == 0) {
+            continue;
+        }
+        char unnamed[16];
+        const char *name = Name(scid);
+        if (name == nullptr) {
+            snprintf(unnamed, sizeof unnamed, "syscall_%u", scid);
+            name = unnamed;
+        }
+        fprintf(file, tabular ? "%s\t%s\t%s\t%lu\t%lu\t%lu\t%lu\t%lu\n"
+                              : "%5s %-16s %-10s %8lu %12lu %8lu %8lu %10lu\n",
+                id, space->name, name, c->calls, c->totalTicks,
+                c->minTicks, c->maxTicks, c->bytes);
+    }
+}
+
+void
+SyscallStats::Print()
+{
+    if (print) {
+        printf("\nSystem calls:\n%5s %-16s %-10s %8s %12s %8s %8s %10s\n",
+               "space", "program", "call", "count", "total ticks",
+               "min", "max", "bytes");
+        PrintSpace(stdout, all, false);
+        for (unsigned i = 0; i < Table<int>::SIZE; i++) {
+            if (spaces[i] != nullptr) {
+                PrintSpace(stdout, spaces[i], false);
+            }
+        }
+    }
+
+    if (fileName != nullptr) {
+        FILE *file = fopen(fileName, "w");
+        if (file == nullptr) {
+            perror(fileName);
+            return;
+        }
+        fprintf(file, "space\tprogram\tcall\tcount\ttotal_ticks\tmin_ticks"
+                      "\tmax_ticks\tbytes\n");
+        PrintSpace(file, all, true);
+        for (unsigned i = 0; i < Table<int>::SIZE; i++) {
+            if (spaces[i] != nullptr) {
+                PrintSpace(file, spaces[i], true);
+            }
+        }
+        fclose(file);
+    }
+}
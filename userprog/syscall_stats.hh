@@ -0,0 +1,103 @@
+/// Counts and latencies of the system calls made by user programs.
+///
+/// With `-sc`, `SyscallHandler` records every call: how many times each
+/// process made it, the simulated ticks it took (from entering the kernel
+/// until returning to user mode, so time spent blocked counts too), and the
+/// bytes it moved, for the calls that read or write or pass messages; the
+/// bytes of ring requests count for the `IoEnter` that completes them.  A
+/// table is printed when the machine halts, and with `-scf` it is also
+/// written to a file, as tab separated values.  With `-st`, every call is
+/// also logged to standard error as it returns, in the manner of `strace`.
+///
+/// Processes are identified by their `SpaceId`.  Identifiers are reused, so
+/// a row can add up several processes that ran one after the other.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_SYSCALLSTATS__HH
+#define NACHOS_USERPROG_SYSCALLSTATS__HH
+
+
+#include "lib/table.hh"
+
+#include <stdio.h>
+
+
+/// System call numbers are below this.
+const unsigned MAX_SYSCALLS = 64;
+
+/// Length kept of the name of a process.
+const unsigned SYSCALL_STATS_NAME_LENGTH = 32;
+
+/// What is known of one system call.
+struct SyscallCounter {
+    unsigned long calls;
+    unsigned long totalTicks;
+    unsigned long minTicks;
+    unsigned long maxTicks;
+    unsigned long bytes;
+};
+
+/// The counters of one process.
+struct SpaceSyscallStats {
+    int spaceId;
+    char name[SYSCALL_STATS_NAME_LENGTH];
+    SyscallCounter counters[MAX_SYSCALLS];
+};
+
+class SyscallStats {
+public:
+
+    /// Collect statistics.  `print` tells whether to print the table at the
+    /// end, `fileName`, if not null, where to write it, and `trace` whether
+    /// to log every call.
+    SyscallStats(bool print, const char *fileName, bool trace);
+
+    ~SyscallStats();
+
+    /// Record that the current process made the system call `scid`, which
+    /// took `ticks` and left `result` in register 2.  The arguments are
+    /// taken from the registers, which system calls do not change.
+    void Record(int scid, unsigned long ticks, int result);
+
+    /// Record that the current process called `Exit` or `Halt`, which never
+    /// return.
+    void RecordNoReturn(int scid);
+
+    /// Add `bytes` to the data moved by the call `scid` of the current
+    /// process, for transfers that its result does not tell.
+    void AddBytes(int scid, unsigned long bytes);
+
+    /// Print the table, and write it to the file, if asked to.
+    void Print();
+
+    /// Return the name of `scid`, or null if there is no such call.
+    static const char *Name(int scid);
+
+private:
+
+    /// Return the counters of the current process, creating them if
+    /// needed.
+    SpaceSyscallStats *Current();
+
+    /// Write a line for every call made in `space` on `file`, in aligned
+    /// columns, or separated by tabs if `tabular`.
+    static void PrintSpace(FILE *file, const SpaceSyscallStats *space,
+                           bool tabular);
+
+    bool print;
+    const char *fileName;
+    bool trace;
+
+    /// Counters of every process, indexed by `SpaceId`; null until it makes
+    /// its first call.
+    SpaceSyscallStats *spaces[Table<int>::SIZE];
+
+    /// Totals of every process.
+    SpaceSyscallStats *all;
+};
+
+
+#endif
@@ -6,34 +6,96 @@
 #include "transfer.hh"
 #include "lib/utility.hh"
 #include "threads/system.hh"
+
 #include <stdio.h>
+#include <string.h>
+
+
+/// Whether the handler of exception `e`, raised by an access to user
+/// memory, can resolve it, so that the access is worth retrying.  Other
+/// exceptions mean the address is not in the memory of the program.
+static inline bool
+CanResolve(ExceptionType e)
+{
+#ifdef USE_TLB
+    if (e == PAGE_FAULT_EXCEPTION) {
+        return true;  // A TLB miss, or a page not loaded yet.
+    }
+#endif
+#ifdef SWAP
+    if (e == READ_ONLY_EXCEPTION) {
+        return true;  // A page shared with other processes.
+    }
+#endif
+    return false;
+}
+
+/// Return where the byte at `userAddress` is in physical memory, for
+/// reading or `writing`, or null if it is not in the memory of the program.
+///
+/// If the translation fails, the exception is raised so that its handler
+/// resolves it (loads the page, refills the TLB or gives this process its
+/// own copy of a shared page), and the translation is tried again.  The
+/// result is only valid until the next page is translated: that can evict
+/// this one.
+static char *
+UserMemory(int userAddress, bool writing)
+{
+    MMU *mmu = machine->GetMMU();
+    unsigned physicalAddress;
+
+#ifdef DEMAND_LOADING
+    // The page fault handler would end the process instead.
+    if (!currentThread->space->IsValidPage((unsigned) userAddress / PAGE_SIZE)) {
+        DEBUG('e', "User address %d is not valid\n", userAddress);
+        return nullptr;
+    }
+#endif
+
+    for (unsigned i = 0; i < NUMBER_OF_TRIES; i++) {
+        ExceptionType e = mmu->Translate(userAddress, &physicalAddress, 1,
+                                         writing);
+        if (e == NO_EXCEPTION) {
+            return &mmu->mainMemory[physicalAddress];
+        }
+        if (!CanResolve(e)) {
+            break;
+        }
+        machine->RaiseException(e, userAddress);
+    }
 
+    DEBUG('e', "Cannot translate user address %d\n", userAddress);
+    return nullptr;
+}
+
+/// Number of bytes from `userAddress` to the end of its page, up to
+/// `byteCount`.
+static inline unsigned
+BytesInPage(int userAddress, unsigned byteCount)
+{
+    unsigned left = PAGE_SIZE - (unsigned) userAddress % PAGE_SIZE;
+    return left < byteCount ? left : byteCount;
+}
 
-void ReadBufferFromUser(int userAddress, char *outBuffer,
+bool ReadBufferFromUser(int userAddress, char *outBuffer,
                         unsigned byteCount)
 {
     ASSERT(userAddress != 0);
     ASSERT(outBuffer != nullptr);
-    ASSERT(byteCount > 0 && byteCount <= LSDIR_OUTPUT);
-
-    unsigned count = 0;
-
-    int temp;
-    do {
-        count++;
-        for(unsigned i = 0;  i < NUMBER_OF_TRIES; ++i){
-            if(machine->ReadMem(userAddress, 1, &temp)){
-                userAddress++;
-                break;
-            }
-        }
-        *outBuffer = (unsigned char) temp;
-        outBuffer++;
-    } while (count < byteCount);
-
-    *outBuffer = (unsigned char)'\0';
+    ASSERT(byteCount > 0);
 
-    return;
+    while (byteCount > 0) {
+        unsigned chunk = BytesInPage(userAddress, byteCount);
+        const char *from = UserMemory(userAddress, false);
+        if (from == nullptr) {
+            return false;
+        }
+        memcpy(outBuffer, from, chunk);
+        userAddress += chunk;
+        outBuffer   += chunk;
+        byteCount   -= chunk;
+    }
+    return true;
 }
 
 bool ReadStringFromUser(int userAddress, char *outString,
@@ -43,61 +105,50 @@ bool ReadStringFromUser(int userAddress, char *outString,
     ASSERT(outString != nullptr);
     ASSERT(maxByteCount != 0);
 
-    unsigned count = 0;
-    do {
-        int temp;
-        count++;
-        for(unsigned i = 0; i < NUMBER_OF_TRIES; ++i){
-            if(machine->ReadMem(userAddress, 1, &temp)){
-                userAddress++;
-                break;
-            }
+    while (maxByteCount > 0) {
+        unsigned chunk = BytesInPage(userAddress, maxByteCount);
+        const char *from = UserMemory(userAddress, false);
+        if (from == nullptr) {
+            return false;
         }
-        *outString = (unsigned char) temp;
-    } while (*outString++ != '\0' && count < maxByteCount);
-
-    return *(outString - 1) == '\0';
+        const char *end  = (const char *) memchr(from, '\0', chunk);
+        if (end != nullptr) {
+            memcpy(outString, from, end - from + 1);
+            return true;
+        }
+        memcpy(outString, from, chunk);
+        userAddress  += chunk;
+        outString    += chunk;
+        maxByteCount -= chunk;
+    }
+    return false;
 }
 
-void WriteBufferToUser(const char *buffer, int userAddress,
+bool WriteBufferToUser(const char *buffer, int userAddress,
                        unsigned byteCount)
 {
     ASSERT(userAddress != 0);
     ASSERT(buffer != nullptr);
-    ASSERT(byteCount > 0 && byteCount <= LSDIR_OUTPUT);
+    ASSERT(byteCount > 0);
 
-    unsigned count = 0;
-
-    do{
-        count++;
-        for(unsigned i = 0; i < NUMBER_OF_TRIES; ++i){
-            if(machine->WriteMem(userAddress, 1, *(int*) buffer)){
-                userAddress++;
-                break;
-            }
+    while (byteCount > 0) {
+        unsigned chunk = BytesInPage(userAddress, byteCount);
+        char *to = UserMemory(userAddress, true);
+        if (to == nullptr) {
+            return false;
         }
-
-    } while(*buffer++ != '\0' && count < byteCount);
-
-    return;
-
+        memcpy(to, buffer, chunk);
+        userAddress += chunk;
+        buffer      += chunk;
+        byteCount   -= chunk;
+    }
+    return true;
 }
 
-void WriteStringToUser(const char *string, int userAddress)
+bool WriteStringToUser(const char *string, int userAddress)
 {
     ASSERT(userAddress != 0);
     ASSERT(string != nullptr);
 
-    unsigned count = 0;
-    do {
-        count++;
-        for(unsigned i = 0; i < NUMBER_OF_TRIES; ++i){
-            if(machine->WriteMem(userAddress, 1, *(int*) string)){
-                userAddress++;
-                break;
-            }
-        }
-
-    } while (*string++ != '\0');
-    return;
+    return WriteBufferToUser(string, userAddress, strlen(string) + 1);
 }
@@ -1,3 +1,13 @@
+/// Copy data between the kernel and the memory of the running user program.
+///
+/// Every routine translates each user page once and copies the part of the
+/// buffer that falls in it with `memcpy`.  Pages that are not available
+/// (not loaded yet, missing from the TLB, or read-only after a `Fork`) are
+/// brought in by raising the same exception a user instruction would, so
+/// buffers can be of any size.  Addresses outside the memory of the program
+/// make a routine return false instead, so that a bad pointer handed to a
+/// system call only makes that call fail.
+///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
 ///               2016-2021 Docentes de la Universidad Nacional de Rosario.
 /// All rights reserved.  See `copyright.h` for copyright notice and
@@ -8,20 +18,25 @@
 
 const unsigned LSDIR_OUTPUT = 200;
 
-/// Copy a byte array from virtual machine to host.
-void ReadBufferFromUser(int userAddress, char *outBuffer,
+/// Copy a byte array from virtual machine to host.  Return false if part
+/// of it is not in the memory of the program.
+bool ReadBufferFromUser(int userAddress, char *outBuffer,
                         unsigned byteCount);
 
-/// Copy a C string from virtual machine to host.
+/// Copy a C string from virtual machine to host.  Return false if there is
+/// no null byte within the first `maxByteCount` bytes, or if part of them
+/// is not in the memory of the program.
 bool ReadStringFromUser(int userAddress, char *outString,
                         unsigned maxByteCount);
 
-/// Copy a byte array from host to virtual machine.
-void WriteBufferToUser(const char *buffer, int userAddress,
+/// Copy a byte array from host to virtual machine.  Return false if part of
+/// it is not in the memory of the program.
+bool WriteBufferToUser(const char *buffer, int userAddress,
                        unsigned byteCount);
 
-/// Copy a C string from host to virtual machine.
-void WriteStringToUser(const char *string, int userAddress);
+/// Copy a C string from host to virtual machine.  Return false like
+/// `WriteBufferToUser`.
+bool WriteStringToUser(const char *string, int userAddress);
 
 
 #endif
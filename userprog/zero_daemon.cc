@@ -0,0 +1,136 @@
+/// Routines for the frame zeroing daemon.
+///
+/// Frames are picked and cleared with interrupts disabled, so nobody can
+/// allocate a frame while the daemon is clearing it.  The daemon only ever
+/// writes free frames, which hold nothing anybody will read.
+///
+/// Nachos halts when the main thread finishes and no other thread is ready
+/// (see `Thread::Finish`).  Processes wake the daemon up when they exit, so
+/// once the main thread is gone the daemon puts itself to sleep the same
+/// way, instead of waiting for more work that will never come.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "zero_daemon.hh"
+#include "threads/system.hh"
+
+#include <string.h>
+
+
+static void
+ZeroDaemonHelper(void *arg)
+{
+    ((ZeroDaemon *) arg)->Run();
+}
+
+ZeroDaemon::ZeroDaemon()
+{
+    zeroedFrames = new Bitmap(NUM_PHYS_PAGES);
+    for (unsigned i = 0; i < NUM_PHYS_PAGES; i++) {
+        if (!addressesBitMap->Test(i)) {
+            zeroedFrames->Mark(i);
+        }
+    }
+    request = new Semaphore("zero daemon request", 0);
+    pending = false;
+    stopping = false;
+
+    Thread *t = new Thread("zero daemon", false, ZERO_DAEMON_PRIORITY);
+    t->Fork(ZeroDaemonHelper, this);
+}
+
+ZeroDaemon::~ZeroDaemon()
+{
+    delete request;
+    delete zeroedFrames;
+}
+
+int
+ZeroDaemon::TakeFrame(bool wantZeroed, bool *zeroed)
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    int frame = -1;
+    for (unsigned i = 0; i < NUM_PHYS_PAGES; i++) {
+        if (addressesBitMap->Test(i)) {
+            continue;
+        }
+        if (zeroedFrames->Test(i) == wantZeroed) {
+            frame = i;
+            break;
+        }
+        if (frame == -1) {
+            frame = i;  // not the preferred kind, but keep it just in case
+        }
+    }
+
+    if (frame != -1) {
+        addressesBitMap->Mark(frame);
+        if (zeroed != nullptr) {
+            *zeroed = zeroedFrames->Test(frame);
+        }
+        zeroedFrames->Clear(frame);
+    }
+
+    interrupt->SetLevel(oldLevel);
+    return frame;
+}
+
+void
+ZeroDaemon::Wake()
+{
+    if (pending || stopping) {
+        return;
+    }
+    pending = true;
+    request->V();
+}
+
+void
+ZeroDaemon::Stop()
+{
+    stopping = true;
+}
+
+void
+ZeroDaemon::Run()
+{
+    char *mainMemory = machine->GetMMU()->mainMemory;
+
+    for (;;) {
+        request->P();
+        pending = false;
+
+        for (;;) {
+            // Only use time nobody else wants.
+            while (!stopping && !scheduler->GetReadyList()->IsEmpty()) {
+                currentThread->Yield();
+            }
+            if (stopping) {
+                interrupt->SetLevel(INT_OFF);
+                currentThread->Sleep(true);  // never woken up again
+            }
+
+            IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+            int frame = -1;
+            for (unsigned i = 0; i < NUM_PHYS_PAGES && frame == -1; i++) {
+                if (!addressesBitMap->Test(i) && !zeroedFrames->Test(i)) {
+                    frame = i;
+                }
+            }
+            if (frame != -1) {
+                memset(&mainMemory[frame * PAGE_SIZE], 0, PAGE_SIZE);
+                zeroedFrames->Mark(frame);
+                stats->numFramesZeroed++;
+            }
+            interrupt->SetLevel(oldLevel);
+
+            if (frame == -1) {
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,70 @@
+/// Kernel thread that zeroes free frames ahead of time.
+///
+/// Pages that are not read from anywhere (the heap, the stack,
+/// uninitialized data, new pages of shared segments) must start out filled
+/// with zeros.  Instead of clearing their frames when they are loaded, the
+/// daemon clears free frames while no other thread is ready to run, and
+/// remembers which ones are zeroed.  Frames are handed out by `TakeFrame`,
+/// which gives the zeroed ones to the pages that need them, and keeps them
+/// away from pages that are going to be overwritten completely anyway.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_ZERODAEMON__HH
+#define NACHOS_USERPROG_ZERODAEMON__HH
+
+
+#include "lib/bitmap.hh"
+#include "threads/semaphore.hh"
+
+
+/// Scheduling priority of the daemon.  It does not matter much, since it
+/// gives up the CPU whenever another thread is ready.
+const unsigned ZERO_DAEMON_PRIORITY = 0;
+
+class ZeroDaemon {
+public:
+
+    /// Create the daemon thread.  Physical memory starts out zeroed, so it
+    /// starts sleeping.
+    ZeroDaemon();
+
+    ~ZeroDaemon();
+
+    /// Allocate a free frame in `addressesBitMap`, and return it, or -1 if
+    /// there is none.  Store in `zeroed`, if not null, whether the frame
+    /// is all zero.
+    ///
+    /// If `wantZeroed`, prefer a zeroed frame; otherwise, prefer one that
+    /// is not, to keep the zeroed ones for later.
+    int TakeFrame(bool wantZeroed, bool *zeroed);
+
+    /// Some frames were freed: zero them when there is time.
+    ///
+    /// Does nothing if a request is already pending.
+    void Wake();
+
+    /// The main thread is finishing: stop zeroing, and do not keep Nachos
+    /// from halting.
+    void Stop();
+
+    /// Body of the daemon thread.  Never returns.
+    void Run();
+
+private:
+
+    /// Free frames known to be all zero.
+    Bitmap *zeroedFrames;
+
+    Semaphore *request;
+
+    /// Whether `request` was signalled and the daemon did not serve it yet.
+    bool pending;
+
+    bool stopping;
+};
+
+
+#endif
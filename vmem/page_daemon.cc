@@ -0,0 +1,147 @@
+/// Routines for the page-out daemon.
+///
+/// Every pass runs with `coreMapLock` held, so the daemon never looks at a
+/// frame that a page fault has just allocated but not yet filled.  It runs
+/// in a thread without an address space, so by the time it executes the TLB
+/// has already been written back to the page tables (see
+/// `AddressSpace::SaveState`) and the page table entries are up to date.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "page_daemon.hh"
+#include "threads/system.hh"
+
+#ifdef SWAP
+
+
+static void
+PageDaemonHelper(void *arg)
+{
+    ((PageDaemon *) arg)->Run();
+}
+
+PageDaemon::PageDaemon()
+{
+    request = new Semaphore("page daemon request", 0);
+    pending = false;
+    stopping = false;
+
+    // Keep at least one frame free, however small memory is.
+    lowWatermark  = NUM_PHYS_PAGES / PAGEOUT_LOW_FRACTION;
+    if (lowWatermark == 0) {
+        lowWatermark = 1;
+    }
+    highWatermark = NUM_PHYS_PAGES / PAGEOUT_HIGH_FRACTION;
+    if (highWatermark <= lowWatermark) {
+        highWatermark = lowWatermark + 1;
+    }
+
+    Thread *t = new Thread("page daemon", false, PAGEOUT_PRIORITY);
+    t->Fork(PageDaemonHelper, this);
+}
+
+PageDaemon::~PageDaemon()
+{
+    delete request;
+}
+
+unsigned
+PageDaemon::GetLowWatermark() const
+{
+    return lowWatermark;
+}
+
+void
+PageDaemon::Wake()
+{
+    if (pending || stopping) {
+        return;
+    }
+    if (swapArea->CountFree() == 0) {
+        // The daemon could only evict clean pages, which page faults do
+        // just as well; waking it up on every fault would only take the
+        // CPU, and the TLB, away from the faulting process.
+        return;
+    }
+    DEBUG('a', "Waking up the page daemon, %u free frames\n",
+          addressesBitMap->CountClear());
+    pending = true;
+    request->V();
+}
+
+void
+PageDaemon::Stop()
+{
+    // Wake the daemon up one last time, so that it does not go to sleep
+    // waiting for a request when it is done with the current one.
+    stopping = true;
+    request->V();
+}
+
+void
+PageDaemon::Run()
+{
+    for (;;) {
+        request->P();
+        pending = false;
+        if (stopping) {
+            interrupt->SetLevel(INT_OFF);
+            currentThread->Sleep(true);  // never woken up again
+        }
+
+        coreMapLock->Acquire();
+        CleanFrames();
+        FreeFrames();
+        coreMapLock->Release();
+        zeroDaemon->Wake();
+    }
+}
+
+void
+PageDaemon::CleanFrames()
+{
+    for (unsigned frame = 0; frame < NUM_PHYS_PAGES; frame++) {
+        if (!addressesBitMap->Test(frame) || coreMap[frame]->refCount == 0
+              || coreMap[frame]->inTransit) {
+            continue;
+        }
+        bool use, dirty;
+        AddressSpace::FrameBits(frame, &use, &dirty);
+        if (use) {
+            // Referenced since the last pass, by any of the processes that
+            // map it: likely to be written again, so leave it alone this
+            // time.
+            AddressSpace::ClearFrameUse(frame);
+#ifdef PRPOLICY_WSCLOCK
+            coreMap[frame]->last_use_tick = stats->totalTicks;
+#endif
+        } else {
+            int cleaned = AddressSpace::CleanFrame(frame);
+            if (cleaned > 0) {
+                DEBUG('a', "Page daemon cleaned frame %u (%d pages)\n",
+                      frame, cleaned);
+                stats->numPagesCleaned += cleaned;
+            }
+        }
+    }
+}
+
+void
+PageDaemon::FreeFrames()
+{
+    while (addressesBitMap->CountClear() < highWatermark) {
+        int frame = AddressSpace::EvacuatePage();
+        if (frame == -1) {
+            // Swap is full; faulting processes find out on their own.
+            break;
+        }
+        DEBUG('a', "Page daemon freed frame %d\n", frame);
+        addressesBitMap->Clear(frame);
+    }
+}
+
+
+#endif
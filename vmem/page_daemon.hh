@@ -0,0 +1,80 @@
+/// Kernel thread that keeps a pool of free page frames.
+///
+/// When the number of free frames drops below the low watermark, the page
+/// fault handler wakes the daemon up.  It then writes modified pages back
+/// to swap ahead of time and evicts pages, following the replacement
+/// policy, until at least the high watermark of frames are free again.
+/// That way most page faults find a free frame and only have to read the
+/// missing page, instead of also writing a dirty victim first.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_VMEM_PAGEDAEMON__HH
+#define NACHOS_VMEM_PAGEDAEMON__HH
+
+
+#include "machine/mmu.hh"
+#include "threads/semaphore.hh"
+
+
+/// The daemon is woken up when fewer than this fraction of the frames are
+/// free...
+const unsigned PAGEOUT_LOW_FRACTION = 8;
+
+/// ...and goes back to sleep once this fraction of them is free.
+const unsigned PAGEOUT_HIGH_FRACTION = 4;
+
+/// Scheduling priority of the daemon.  Higher than the one of user
+/// programs, so that it runs as soon as the faulting process gives up the
+/// CPU.
+const unsigned PAGEOUT_PRIORITY = 1;
+
+class PageDaemon {
+public:
+
+    /// Create the daemon thread; it starts sleeping.
+    PageDaemon();
+
+    ~PageDaemon();
+
+    /// Number of free frames below which the daemon should be woken up.
+    unsigned GetLowWatermark() const;
+
+    /// Ask the daemon to refill the pool of free frames.
+    ///
+    /// Does nothing if a request is already pending, or if the swap area is
+    /// full.
+    void Wake();
+
+    /// The main thread is finishing: do not keep Nachos from halting.
+    void Stop();
+
+    /// Body of the daemon thread.  Never returns.
+    void Run();
+
+private:
+
+    /// Write back the modified pages that were not referenced since the
+    /// previous pass, so that evicting them later does not require any I/O.
+    /// The `use` bits are cleared along the way.
+    void CleanFrames();
+
+    /// Evict pages until `highWatermark` frames are free, or until the swap
+    /// area has no room for the page to evict.
+    void FreeFrames();
+
+    unsigned lowWatermark;
+    unsigned highWatermark;
+
+    Semaphore *request;
+
+    /// Whether `request` was signalled and the daemon did not serve it yet.
+    bool pending;
+
+    bool stopping;
+};
+
+
+#endif
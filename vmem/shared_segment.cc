@@ -0,0 +1,109 @@
+/// Routines to keep track of shared memory segments.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "shared_segment.hh"
+#include "threads/system.hh"
+
+#include <limits.h>
+
+#ifdef SWAP
+
+
+SharedSegment::SharedSegment(unsigned numPagesParam)
+{
+    ASSERT(numPagesParam > 0);
+
+    numPages = numPagesParam;
+    numAttached = 0;
+
+    frames = new unsigned [numPages];
+    slots  = new int [numPages];
+    dirty  = new bool [numPages];
+    for (unsigned i = 0; i < numPages; i++) {
+        frames[i] = INT_MAX;
+        slots[i]  = -1;
+        dirty[i]  = false;
+    }
+}
+
+SharedSegment::~SharedSegment()
+{
+    for (unsigned i = 0; i < numPages; i++) {
+        ASSERT(frames[i] == INT_MAX);
+        if (slots[i] != -1) {
+            swapArea->FreeSlot(slots[i]);
+        }
+    }
+    delete [] frames;
+    delete [] slots;
+    delete [] dirty;
+}
+
+unsigned
+SharedSegment::GetNumPages() const
+{
+    return numPages;
+}
+
+bool
+SharedSegment::Attach(AddressSpace *space, unsigned firstVpn)
+{
+    ASSERT(space != nullptr);
+
+    if (numAttached == MAX_SEGMENT_ATTACHMENTS) {
+        return false;
+    }
+    attachments[numAttached].space    = space;
+    attachments[numAttached].firstVpn = firstVpn;
+    numAttached++;
+    return true;
+}
+
+void
+SharedSegment::Detach(AddressSpace *space, unsigned firstVpn)
+{
+    for (unsigned i = 0; i < numAttached; i++) {
+        if (attachments[i].space == space
+              && attachments[i].firstVpn == firstVpn) {
+            attachments[i] = attachments[--numAttached];
+            return;
+        }
+    }
+    ASSERT(false);
+}
+
+unsigned
+SharedSegment::CountAttached() const
+{
+    return numAttached;
+}
+
+unsigned
+SharedSegment::GetAttachments(AddressSpace **spaces,
+                              unsigned *firstVpns) const
+{
+    for (unsigned i = 0; i < numAttached; i++) {
+        spaces[i]    = attachments[i].space;
+        firstVpns[i] = attachments[i].firstVpn;
+    }
+    return numAttached;
+}
+
+unsigned
+SharedSegment::PageOf(unsigned frame) const
+{
+    for (unsigned i = 0; i < numPages; i++) {
+        if (frames[i] == frame) {
+            return i;
+        }
+    }
+    ASSERT(false);
+    return 0;
+}
+
+
+#endif
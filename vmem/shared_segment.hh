@@ -0,0 +1,81 @@
+/// Shared memory segments.
+///
+/// A segment is a set of pages that several processes map into their
+/// address spaces, possibly at different addresses, so that what one of
+/// them writes is seen by the others without going through the kernel.
+///
+/// Pages of a segment are loaded on demand and can be evicted like any
+/// other, so the segment itself keeps track of where each of its pages is:
+/// in a frame, which is then mapped by every attached process that
+/// references it, in a swap slot, or nowhere yet (it reads as zero).
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_VMEM_SHAREDSEGMENT__HH
+#define NACHOS_VMEM_SHAREDSEGMENT__HH
+
+
+class AddressSpace;
+
+/// Maximum number of times a segment can be attached at once.
+const unsigned MAX_SEGMENT_ATTACHMENTS = 16;
+
+/// Maximum size of a segment, in pages.
+const unsigned MAX_SEGMENT_PAGES = 64;
+
+class SharedSegment {
+public:
+
+    /// Create a segment of `numPages` pages, all of them zero.
+    SharedSegment(unsigned numPages);
+
+    /// Give back the swap slots of the segment.  Its frames must have been
+    /// freed already.
+    ~SharedSegment();
+
+    unsigned GetNumPages() const;
+
+    /// Record that `space` maps the segment from page `firstVpn` on.
+    /// Return false if the segment is attached too many times.
+    bool Attach(AddressSpace *space, unsigned firstVpn);
+
+    /// Forget the attachment of `space` at page `firstVpn`.
+    void Detach(AddressSpace *space, unsigned firstVpn);
+
+    unsigned CountAttached() const;
+
+    /// Store in `spaces` and `firstVpns` where the segment is attached, and
+    /// return how many attachments there are.
+    unsigned GetAttachments(AddressSpace **spaces, unsigned *firstVpns) const;
+
+    /// Return the page of the segment held in `frame`, which must be one
+    /// of its frames.
+    unsigned PageOf(unsigned frame) const;
+
+    /// Frame holding each page, `INT_MAX` if the page is not in memory.
+    unsigned *frames;
+
+    /// Swap slot holding the copy of each page, -1 if none.
+    int *slots;
+
+    /// Whether each page was modified by a process that detached from the
+    /// segment since it was last written to swap.  The modifications of the
+    /// processes still attached are in their page tables.
+    bool *dirty;
+
+private:
+
+    unsigned numPages;
+
+    struct Attachment {
+        AddressSpace *space;
+        unsigned firstVpn;
+    };
+    Attachment attachments[MAX_SEGMENT_ATTACHMENTS];
+    unsigned numAttached;
+};
+
+
+#endif
@@ -0,0 +1,142 @@
+/// Routines to manage the swap area.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "swap_area.hh"
+#include "machine/mmu.hh"
+#include "threads/system.hh"
+
+#include <string.h>
+
+#ifdef SWAP
+
+
+SwapArea::SwapArea(const char *name, unsigned numSlotsParam)
+{
+    ASSERT(name != nullptr);
+    ASSERT(numSlotsParam > 0);
+
+    numSlots  = numSlotsParam;
+    slots     = new Bitmap(numSlots);
+    slotUsers = new unsigned [numSlots];
+
+#ifdef FILESYS
+    fileSystem->Create(name, 0, true);
+    file = fileSystem->Open(name, true);
+#else
+    fileSystem->Create(name, 0);
+    file = fileSystem->Open(name);
+#endif
+    if (file == nullptr) {
+        DEBUG('a', "Cannot open the swap file %s\n", name);
+        ASSERT(false);
+    }
+
+    // Extend the file up to its full size right away, so that paging out
+    // never has to grow it.
+    char *zeros = new char [PAGE_SIZE];
+    memset(zeros, 0, PAGE_SIZE);
+    file->WriteAt(zeros, PAGE_SIZE, (numSlots - 1) * PAGE_SIZE);
+    delete [] zeros;
+
+    cache = new SwapCache(file, numSlots);
+}
+
+SwapArea::~SwapArea()
+{
+    delete cache;
+    delete file;
+    delete slots;
+    delete [] slotUsers;
+}
+
+int
+SwapArea::AllocSlots(unsigned count)
+{
+    ASSERT(count > 0 && count <= numSlots);
+
+    unsigned run = 0;
+    for (unsigned i = 0; i < numSlots; i++) {
+        run = slots->Test(i) ? 0 : run + 1;
+        if (run == count) {
+            unsigned first = i + 1 - count;
+            for (unsigned j = first; j <= i; j++) {
+                slots->Mark(j);
+                slotUsers[j] = 1;
+            }
+            return first;
+        }
+    }
+    return -1;
+}
+
+void
+SwapArea::ShareSlot(unsigned slot)
+{
+    ASSERT(slot < numSlots);
+    ASSERT(slots->Test(slot));
+
+    slotUsers[slot]++;
+}
+
+void
+SwapArea::FreeSlot(unsigned slot)
+{
+    ASSERT(slot < numSlots);
+    ASSERT(slots->Test(slot));
+
+    if (--slotUsers[slot] == 0) {
+        slots->Clear(slot);
+        cache->Remove(slot);
+    }
+}
+
+void
+SwapArea::Read(unsigned slot, char *into)
+{
+    ASSERT(slot < numSlots);
+    ASSERT(into != nullptr);
+
+    DEBUG('a', "Reading swap slot %u\n", slot);
+    if (!cache->Load(slot, into)) {
+        file->ReadAt(into, PAGE_SIZE, slot * PAGE_SIZE);
+    }
+}
+
+void
+SwapArea::Write(unsigned first, const char *from, unsigned count)
+{
+    ASSERT(first + count <= numSlots);
+    ASSERT(from != nullptr);
+
+    DEBUG('a', "Writing %u pages into swap slots %u to %u\n",
+          count, first, first + count - 1);
+
+    // The pages that do not go to the cache are written to the file with
+    // one write per run.
+    unsigned run = 0;
+    for (unsigned i = 0; i <= count; i++) {
+        if (i < count && !cache->Store(first + i, &from[i * PAGE_SIZE])) {
+            run++;
+            continue;
+        }
+        if (run > 0) {
+            unsigned start = i - run;
+            file->WriteAt(&from[start * PAGE_SIZE], run * PAGE_SIZE,
+                          (first + start) * PAGE_SIZE);
+            run = 0;
+        }
+    }
+}
+
+unsigned
+SwapArea::CountFree() const
+{
+    return slots->CountClear();
+}
+
+
+#endif
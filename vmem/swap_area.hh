@@ -0,0 +1,82 @@
+/// A swap area shared by all the address spaces.
+///
+/// Swap space is a single file, created and preallocated at startup, divided
+/// in page-sized slots.  A bitmap keeps track of the slots in use, and every
+/// address space remembers which slot holds each of its swapped pages (see
+/// `AddressSpace`).  Runs of contiguous slots can be written with a single
+/// operation, so that neighbouring dirty pages are paged out together.
+///
+/// A slot can be referenced by several address spaces, after a `Fork`; it
+/// only becomes free when every one of them gave it back.
+///
+/// Pages go through a compressed cache on their way to the file (see
+/// `SwapCache`), so most writes and reads never touch it.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_VMEM_SWAPAREA__HH
+#define NACHOS_VMEM_SWAPAREA__HH
+
+
+#include "swap_cache.hh"
+#include "filesys/open_file.hh"
+#include "lib/bitmap.hh"
+
+
+/// Name of the file that backs the swap area.
+#define SWAP_FILE_NAME  "userprog/SWAP/SWAP"
+
+/// Number of page-sized slots in the swap area.
+const unsigned NUM_SWAP_SLOTS = 1024;
+
+/// Maximum number of contiguous pages written in a single operation.
+const unsigned SWAP_CLUSTER_PAGES = 8;
+
+class SwapArea {
+public:
+
+    /// Create the file `name` big enough for `numSlots` pages, with every
+    /// slot free.
+    SwapArea(const char *name, unsigned numSlots);
+
+    /// Close the swap file.
+    ~SwapArea();
+
+    /// Reserve `count` contiguous slots.  Return the first one, or -1 if
+    /// there is no run that long.
+    int AllocSlots(unsigned count);
+
+    /// Add a reference to a slot that is already in use.
+    void ShareSlot(unsigned slot);
+
+    /// Drop a reference to a slot; it is freed with the last one.
+    void FreeSlot(unsigned slot);
+
+    /// Copy the page stored in `slot` into `into`.
+    void Read(unsigned slot, char *into);
+
+    /// Store `count` pages from `from` into the slots starting at `first`.
+    void Write(unsigned first, const char *from, unsigned count);
+
+    /// Number of free slots.
+    unsigned CountFree() const;
+
+private:
+
+    OpenFile *file;
+
+    SwapCache *cache;
+
+    /// Slots in use.
+    Bitmap *slots;
+
+    /// Number of references to each slot in use.
+    unsigned *slotUsers;
+
+    unsigned numSlots;
+};
+
+
+#endif
@@ -0,0 +1,254 @@
+/// Routines to manage the compressed swap cache.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "swap_cache.hh"
+#include "threads/system.hh"
+
+#include <string.h>
+
+#ifdef SWAP
+
+
+/// Format of compressed pages: a sequence of tokens, each of them either
+/// * a byte `n - 1`, below 0x80, followed by a run of `n` literal bytes;
+/// * a byte `0x80 | (length - MIN_MATCH)` followed by a 16-bit little
+///   endian offset: copy `length` bytes from `offset` bytes back in the
+///   output.  Both may overlap.
+static const unsigned MIN_MATCH   = 3;
+static const unsigned MAX_MATCH   = 0x7F + MIN_MATCH;
+static const unsigned MAX_LITERAL = 0x80;
+static const unsigned HASH_SIZE   = 256;
+
+static inline unsigned
+Hash(const char *p)
+{
+    unsigned char a = p[0], b = p[1], c = p[2];
+    return (a * 33 * 33 + b * 33 + c) % HASH_SIZE;
+}
+
+/// Append the literals from `from` to `to` of `page` to `into`, which
+/// already has `*out` bytes.  Return false if that would take more than
+/// `limit` bytes.
+static bool
+EmitLiterals(const char *page, unsigned from, unsigned to,
+             char *into, unsigned *out, unsigned limit)
+{
+    while (from < to) {
+        unsigned n = to - from < MAX_LITERAL ? to - from : MAX_LITERAL;
+        if (*out + 1 + n > limit) {
+            return false;
+        }
+        into[(*out)++] = n - 1;
+        memcpy(&into[*out], &page[from], n);
+        *out += n;
+        from += n;
+    }
+    return true;
+}
+
+/// Compress `page` into `into`, and return the size of the result, or 0
+/// if it would take more than `limit` bytes.
+static unsigned
+Compress(const char *page, char *into, unsigned limit)
+{
+    int last[HASH_SIZE];  // last position where each hash was seen
+    for (unsigned i = 0; i < HASH_SIZE; i++) {
+        last[i] = -1;
+    }
+
+    unsigned out = 0, literalsFrom = 0, i = 0;
+    while (i < PAGE_SIZE) {
+        unsigned length = 0, offset = 0;
+        if (i + MIN_MATCH <= PAGE_SIZE) {
+            unsigned h = Hash(&page[i]);
+            int candidate = last[h];
+            last[h] = i;
+            if (candidate >= 0 && memcmp(&page[candidate], &page[i], MIN_MATCH) == 0) {
+                length = MIN_MATCH;
+                while (i + length < PAGE_SIZE && length < MAX_MATCH
+                         && page[candidate + length] == page[i + length]) {
+                    length++;
+                }
+                offset = i - candidate;
+            }
+        }
+        if (length == 0) {
+            i++;
+            continue;
+        }
+
+        if (!EmitLiterals(page, literalsFrom, i, into, &out, limit)
+              || out + 3 > limit) {
+            return 0;
+        }
+        into[out++] = 0x80 | (length - MIN_MATCH);
+        into[out++] = offset & 0xFF;
+        into[out++] = offset >> 8;
+        i += length;
+        literalsFrom = i;
+    }
+    if (!EmitLiterals(page, literalsFrom, PAGE_SIZE, into, &out, limit)) {
+        return 0;
+    }
+    return out;
+}
+
+static void
+Decompress(const char *data, unsigned size, char *into)
+{
+    unsigned in = 0, out = 0;
+    while (in < size) {
+        unsigned char token = data[in++];
+        if (token & 0x80) {
+            unsigned length = (token & 0x7F) + MIN_MATCH;
+            unsigned offset = (unsigned char) data[in]
+                            | (unsigned char) data[in + 1] << 8;
+            in += 2;
+            ASSERT(offset > 0 && offset <= out && out + length <= PAGE_SIZE);
+            for (unsigned k = 0; k < length; k++, out++) {
+                into[out] = into[out - offset];
+            }
+        } else {
+            unsigned n = token + 1;
+            ASSERT(out + n <= PAGE_SIZE);
+            memcpy(&into[out], &data[in], n);
+            in += n;
+            out += n;
+        }
+    }
+    ASSERT(out == PAGE_SIZE);
+}
+
+SwapCache::SwapCache(OpenFile *file_, unsigned numSlots)
+{
+    ASSERT(file_ != nullptr);
+
+    file   = file_;
+    data   = new char * [numSlots];
+    sizes  = new unsigned [numSlots];
+    fills  = new char [numSlots];
+    cached = new bool [numSlots];
+    for (unsigned i = 0; i < numSlots; i++) {
+        data[i]   = nullptr;
+        cached[i] = false;
+    }
+    order = new List<unsigned>;
+    used  = 0;
+
+    capacity      = SWAP_CACHE_PAGES * PAGE_SIZE;
+    maxCompressed = 3 * PAGE_SIZE / 4;
+    compressed    = new char [maxCompressed];
+    spilled       = new char [PAGE_SIZE];
+}
+
+SwapCache::~SwapCache()
+{
+    while (!order->IsEmpty()) {
+        Remove(order->Head());
+    }
+    delete order;
+    delete [] data;
+    delete [] sizes;
+    delete [] fills;
+    delete [] cached;
+    delete [] compressed;
+    delete [] spilled;
+}
+
+bool
+SwapCache::Store(unsigned slot, const char *page)
+{
+    Remove(slot);
+
+    bool sameFilled = true;
+    for (unsigned i = 1; i < PAGE_SIZE && sameFilled; i++) {
+        sameFilled = page[i] == page[0];
+    }
+    if (sameFilled) {
+        fills[slot]  = page[0];
+        sizes[slot]  = 0;
+        cached[slot] = true;
+        stats->numSwapCacheStores++;
+        stats->numSameFilledPages++;
+        stats->swapCacheBytesIn += PAGE_SIZE;
+        stats->swapCacheBytesOut += 1;
+        return true;
+    }
+
+    unsigned size = Compress(page, compressed, maxCompressed);
+    if (size == 0) {
+        stats->numSwapCacheRejects++;
+        return false;
+    }
+
+    while (used + size > capacity) {
+        Spill();
+    }
+    data[slot] = new char [size];
+    memcpy(data[slot], compressed, size);
+    sizes[slot]  = size;
+    cached[slot] = true;
+    used += size;
+    order->Append(slot);
+
+    stats->numSwapCacheStores++;
+    stats->swapCacheBytesIn += PAGE_SIZE;
+    stats->swapCacheBytesOut += size;
+    return true;
+}
+
+bool
+SwapCache::Load(unsigned slot, char *into)
+{
+    ASSERT(into != nullptr);
+
+    if (!cached[slot]) {
+        stats->numSwapCacheMisses++;
+        return false;
+    }
+
+    if (data[slot] == nullptr) {
+        memset(into, fills[slot], PAGE_SIZE);
+    } else {
+        Decompress(data[slot], sizes[slot], into);
+    }
+    stats->numSwapCacheHits++;
+    return true;
+}
+
+void
+SwapCache::Remove(unsigned slot)
+{
+    if (!cached[slot]) {
+        return;
+    }
+
+    if (data[slot] != nullptr) {  // same-filled pages are not in `order`
+        order->Remove(slot);
+    }
+    used -= sizes[slot];
+    delete [] data[slot];
+    data[slot]   = nullptr;
+    cached[slot] = false;
+}
+
+void
+SwapCache::Spill()
+{
+    ASSERT(!order->IsEmpty());
+
+    unsigned slot = order->Head();
+    Decompress(data[slot], sizes[slot], spilled);
+
+    DEBUG('a', "Spilling swap slot %u to the swap file\n", slot);
+    file->WriteAt(spilled, PAGE_SIZE, slot * PAGE_SIZE);
+    Remove(slot);
+    stats->numSwapCacheSpills++;
+}
+
+
+#endif
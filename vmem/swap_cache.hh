@@ -0,0 +1,84 @@
+/// Compressed cache in front of the swap file.
+///
+/// Pages written to swap are compressed and kept in a pool of kernel memory
+/// of `SWAP_CACHE_PAGES` pages, so that most of them never reach the swap
+/// file.  When the pool is full, the pages that were stored first are
+/// spilled to the file to make room.  Pages whose bytes are all the same
+/// take no room in the pool, and pages that do not compress to less than
+/// three quarters of their size go straight to the file.
+///
+/// Pages are compressed with a small LZ77 variant: a sequence of literal
+/// runs and back references into the part of the page already decoded.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_VMEM_SWAPCACHE__HH
+#define NACHOS_VMEM_SWAPCACHE__HH
+
+
+#include "filesys/open_file.hh"
+#include "lib/list.hh"
+#include "machine/mmu.hh"
+
+
+/// Size of the pool of compressed pages, in pages.
+const unsigned SWAP_CACHE_PAGES = 8;
+
+class SwapCache {
+public:
+
+    /// Create an empty cache for a swap area of `numSlots` slots, backed
+    /// by `file`.
+    SwapCache(OpenFile *file, unsigned numSlots);
+
+    ~SwapCache();
+
+    /// Keep `page` as the content of `slot`, instead of an earlier one, if
+    /// it compresses well enough.  Return false if it does not; then it
+    /// must be written to the file.
+    bool Store(unsigned slot, const char *page);
+
+    /// Copy the content of `slot` into `into`, and return true, if it is in
+    /// the cache.
+    bool Load(unsigned slot, char *into);
+
+    /// Forget the content of `slot`, if it is cached.
+    void Remove(unsigned slot);
+
+private:
+
+    /// Write the page stored first to the file, and remove it.
+    void Spill();
+
+    OpenFile *file;
+
+    /// Compressed content of each cached slot, null if the slot is not
+    /// cached or if its page is filled with `fills[slot]`.
+    char **data;
+
+    /// Compressed size of each cached slot.
+    unsigned *sizes;
+
+    char *fills;
+    bool *cached;
+
+    /// Cached slots that take room in the pool, in the order they were
+    /// stored.
+    List<unsigned> *order;
+
+    /// Bytes of the pool in use, and size of the pool.
+    unsigned used;
+    unsigned capacity;
+
+    /// Pages that take more than this once compressed are not cached.
+    unsigned maxCompressed;
+
+    /// Room for a compressed page, and for a page being spilled.
+    char *compressed;
+    char *spilled;
+};
+
+
+#endif
@@ -0,0 +1,76 @@
+/// Routines to manage the cache of code pages.
+///
+/// There is at most one cached page per frame, so the cache is indexed by
+/// frame, and looking a page up is a scan over the physical memory.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "text_cache.hh"
+#include "threads/system.hh"
+
+#ifdef SWAP
+
+
+TextCache::TextCache()
+{
+    cached = new bool [NUM_PHYS_PAGES];
+    stamps = new FileStamp [NUM_PHYS_PAGES];
+    pages  = new unsigned [NUM_PHYS_PAGES];
+    for (unsigned i = 0; i < NUM_PHYS_PAGES; i++) {
+        cached[i] = false;
+        pages[i]  = 0;
+    }
+}
+
+TextCache::~TextCache()
+{
+    delete [] cached;
+    delete [] stamps;
+    delete [] pages;
+}
+
+int
+TextCache::Find(const FileStamp &stamp, unsigned vpn) const
+{
+    for (unsigned i = 0; i < NUM_PHYS_PAGES; i++) {
+        if (cached[i] && pages[i] == vpn && stamps[i] == stamp) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void
+TextCache::Insert(unsigned frame, const FileStamp &stamp, unsigned vpn)
+{
+    ASSERT(frame < NUM_PHYS_PAGES);
+    ASSERT(!cached[frame]);
+
+    DEBUG('a', "Caching page %u of file %llu:%llu in frame %u\n",
+          vpn, stamp.device, stamp.inode, frame);
+    cached[frame] = true;
+    stamps[frame] = stamp;
+    pages[frame]  = vpn;
+}
+
+void
+TextCache::Remove(unsigned frame)
+{
+    ASSERT(frame < NUM_PHYS_PAGES);
+
+    cached[frame] = false;
+}
+
+bool
+TextCache::Contains(unsigned frame) const
+{
+    ASSERT(frame < NUM_PHYS_PAGES);
+
+    return cached[frame];
+}
+
+
+#endif
@@ -0,0 +1,57 @@
+/// A cache of the code pages of the executables that were run.
+///
+/// Code pages never change, so every process running the same executable
+/// can map the same physical page, read-only.  The cache remembers which
+/// frame holds each code page that was read from an executable, and keeps
+/// it after the last process that mapped it exits, so that running the same
+/// program again does not have to read it either.  Frames that nobody maps
+/// are reclaimed by the replacement policy like any other.
+///
+/// Pages are keyed on the stamp of the executable file rather than on its
+/// name, so that a program that is replaced or rewritten is read again.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_VMEM_TEXTCACHE__HH
+#define NACHOS_VMEM_TEXTCACHE__HH
+
+
+#include "filesys/open_file.hh"
+#include "machine/mmu.hh"
+
+
+class TextCache {
+public:
+
+    /// Create an empty cache.
+    TextCache();
+
+    ~TextCache();
+
+    /// Return the frame that holds page `vpn` of the executable stamped
+    /// `stamp`, or -1 if it is not cached.
+    int Find(const FileStamp &stamp, unsigned vpn) const;
+
+    /// Record that `frame` holds page `vpn` of the executable stamped
+    /// `stamp`.
+    void Insert(unsigned frame, const FileStamp &stamp, unsigned vpn);
+
+    /// Forget the page held in `frame`, if any.
+    void Remove(unsigned frame);
+
+    /// Whether `frame` holds a cached page.
+    bool Contains(unsigned frame) const;
+
+private:
+
+    /// Whether each frame is in the cache, and the executable and page it
+    /// holds if so.
+    bool *cached;
+    FileStamp *stamps;
+    unsigned *pages;
+};
+
+
+#endif